@@ -0,0 +1,1007 @@
+/* The per-board kernels shared by mpi_threads_astar.c and bench_kernels.c:
+ * the Board + LinkedList functions of the original search, the packed
+ * board tables and moves, the NodeTable, OpenList and BucketQueue that
+ * a_star_search() keeps its nodes in, with their memory accounting, and
+ * the lane kernels of lockstep_ida() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include "astar_kernels.h"
+#ifdef LANE_AVX2
+#include <immintrin.h>
+#endif
+
+int nprocs, rank;              // number of processes and rank of the proc
+int initial_arr_size = 15000;  // initial size of the arrays allocated in the A* search
+size_t memory_budget = 0;      // bytes the NodeTables and open lists may take on each proc, 0 for no limit (--memory)
+size_t memory_used = 0;        // bytes held by the NodeTables and OpenLists of this proc, see memory_reserve()
+int memory_low = 0;            // 1 once memory_used has come near memory_budget
+ChangeLog* changed_states = NULL; // where note_change() records states while a_star_search() writes checkpoints
+int manhattan_table[TILES][TILES]; // manhattan_table[value][index] is the distance of tile 'value' at 'index' from its goal
+int move_delta[4] = { -COLS, COLS, -1, 1 }; // change in the index of the 0 tile for each move
+int8_t operator_delta_f[TILES][TILES][4]; // [tile][index of the 0 tile][move] is the change in f = g + h (Manhattan) when the 0 tile makes 'move' and 'tile' slides into its place
+int transpose_index[TILES];    // transpose_index[index] is the index mirrored over the main diagonal
+int transpose_tile[TILES];     // transpose_tile[value] is the tile whose goal square is the mirror of the goal square of 'value'
+int transpose_goal = 1;        // 1 if the goal's 0 tile is on the main diagonal, so a state can be mirrored (see packed_transpose())
+uint64_t table_goal = 0;       // the goal state manhattan_table and the other goal tables are built for
+int goal_index[TILES];         // goal_index[value] is the index of tile 'value' in table_goal
+
+/* Allocate memory for a Board struct.  Set the values all to the default which is
+ * 0 for the heuristic value, NULL for the parent, and 0's for all values in the 
+ * 2d array.  Return a pointer to the resulting Board. */
+Board* make_empty_board(){
+	Board* brd = (Board*)malloc(sizeof(Board));
+	assert(brd);
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			brd->board[i][j] = 0;
+		}
+	}
+	brd->h_score = 0;
+	brd->parent = NULL;
+	return brd;
+}
+
+/* free the allocated Board struct */
+void destroy_board(Board* brd){ 
+	free(brd);
+}
+
+/* print h_score and 2d array of a Board struct */
+void print_board(Board* brd){    
+	printf("H = %d,  ", brd->h_score);
+	printf("Board:\n");
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			printf("%-4d", brd->board[i][j]); // prints values left-justified
+		}
+		printf("\n");
+	}
+}
+
+/* Returns 0 if the 2d arrays are equal and -1 otherwise */
+int compare_boards(int x[ROWS][COLS], int y[ROWS][COLS]){
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			if(x[i][j] != y[i][j]){
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Copies all values from Board A to Board B */
+void copy_board(Board* a, Board* b){
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			b->board[i][j] = a->board[i][j];
+		}
+	}
+	b->h_score = a->h_score;
+	b->parent = a->parent;
+}
+
+
+/* Create and return an Action struct with the given values */
+Action make_action(char* direction, int row, int col, int value){
+	Action a;
+	a.direction = direction;
+	a.row = row;
+	a.col = col;
+	a.value = value;
+	return a;
+}
+
+/* Print all values of an Action in a readable manner */
+void print_action(Action act){
+	printf("Move %d in Row: %d  Column: %d %s\n", act.value, act.row, act.col, act.direction);
+}
+
+/* Creates and allocates space for a single node with given board.
+ * Set next value to NULL initially */
+Node* make_node(Board* brd){
+	Node* result = malloc(sizeof(Node));
+	assert(result);
+	result->board = brd;
+	result->next = NULL;
+	return result;
+}
+
+/* Free memory allocated for the Node */
+void destroy_node(Node* node){
+	destroy_board(node->board);
+	free(node);
+}
+
+/* Allocates space for a linkedlist.  Sets the head and tail 
+ * pointers to NULL and initial size to 0. */
+LinkedList* make_list(){
+	LinkedList* list = malloc(sizeof(LinkedList));
+	assert(list);
+	list->head = NULL;
+	list->tail = NULL;
+	list->size = 0;
+	return list;
+}
+
+/* Free memory allocated for the linkedlist */
+void free_list(LinkedList* list){
+	Node* tmp =  list->head;
+	while(tmp != list->tail){
+		Node* delete = tmp;
+		tmp = tmp->next;
+		destroy_node(delete);
+	}
+	free(list->tail);
+	free(list);
+}
+
+/* Prints a given list in an easily readable manner */
+void print_list(LinkedList* list){
+	Node* tmp = list->head;
+	while(tmp != list->tail){
+		Node* next = tmp;
+		print_board(tmp->board);
+		tmp = tmp->next;
+	}
+	print_board(list->tail->board);
+}
+
+/* Prints a node and all of its parents.  Used to print and visualize
+ * the sequence taken to reach a solution in a_star_search */
+ void print_parents(Node* node){
+ 	int steps = 0; // keep track of how many moves it took to solve (equal to number of parents
+ 	printf("\n----- SOLUTION SEQUENCE -----\n");
+ 	while(node->board->parent != NULL){
+ 		printf("\n");
+ 		print_board(node->board);
+ 		node->board = node->board->parent;
+ 		steps++;
+ 	}
+ 	printf("\n----- SOLUTION SEQUENCE -----\n");
+ 	printf("\n----------------------------------\n");
+ 	printf("\nNumber of moves to solution: %d\n", steps);
+ 	printf("\n----------------------------------\n\n");
+ }
+
+/* Add the given node to the end of the given linkedlist*/
+void push(LinkedList* ll, Node* node){
+	if(ll->size == 0){
+		ll->head = node;
+		ll->tail = node;
+		ll->size++;
+	}else if(ll->size == 1){
+		ll->head->next = node;
+		ll->tail = node;
+		ll->size++;
+	}else{
+		ll->tail->next = node;
+		ll->tail = node;
+		ll->size++;
+	}
+}
+
+/* Remove the first node in the given linkedlist */
+void pop(LinkedList* list){
+	if(list->size == 1){
+		destroy_node(list->head);
+		list->head = NULL;
+		list->tail = NULL;
+		list->size--;
+	}else if(list->size == 2){
+		destroy_node(list->head);
+		list->head = list->tail;
+		list->size--;
+	}else{
+		Node* tmp = list->head->next;
+		destroy_node(list->head);
+		list->head = tmp;
+		list->size--;
+	}
+}
+
+/* Delete the given node from the LinkedList and update pointers */
+void remove_node(LinkedList* list, Node* node){
+	if(list->size == 1){
+		list->head = NULL;
+		list->tail = NULL;
+		list->size--;
+	} else if(list->size == 2){
+		if(list->head == node){
+			list->head = list->tail;
+			list->size--;
+		} else {
+			list->tail = list->head;
+			list->size--;
+		}
+	} else {
+		if(list->head == node){
+			Node* tmp = list->head;
+			list->head = list->head->next;
+			list->size--;
+		} else if (list->tail == node){
+			Node* prev = list->head;
+			while(prev->next->next != NULL){ // find tails previous node 
+				prev = prev->next;
+			}
+			list->tail = prev;
+			list->size--;
+		} else {
+			Node* prev = list->head;
+			while(prev->next != node && prev->next != NULL){ // find previous node of node to be deleted
+				prev = prev->next;
+			}
+			prev->next = prev->next->next;
+			list->size--;
+		}
+	}
+}
+
+/* Stored the linkedlist in an array (NOT USED)) */
+Board** list_to_array(LinkedList* list){
+	Board** result = malloc(initial_arr_size * sizeof(Board*));
+	assert(result);
+	int index = 0;
+	Node* current = list->head;
+
+	while(current != NULL){
+		result[index] = current->board;
+		current = current->next;
+		index++;
+	}
+	return result;
+}
+
+/* Double the size of the given array and return the new doubled array
+ * (NOT USED) */
+Board** double_array(Board** old_array, int array_size){
+	Board** result = malloc((array_size*2) * sizeof(Board*));
+	assert(result);
+	//#pragma omp parallel for
+	for(int i = 0; i < array_size; i++){
+		result[i] = old_array[i];
+	}
+	free(old_array);
+	return result;
+}
+
+/* Returns the node in the list with the minimum h_score value */
+Node* find_min_h(LinkedList* list){
+	int min = INT_MAX;
+	Node* tmp = list->head;
+	Node* result;
+	while(tmp != list->tail){
+		if(min > tmp->board->h_score){  // if h is smaller than current min, set new min
+			min = tmp->board->h_score;
+			result = tmp;
+		}
+		tmp = tmp->next;
+	}
+	if(min > list->tail->board->h_score){
+		min = list->tail->board->h_score;
+		result = list->tail;
+	}
+	return result;
+}
+
+/* Finds the minimum h value in the given list within the range
+ * from start to stop.  Start and stop are the first and last values
+ * for each process to explore */
+Node* find_min_h_parallel(LinkedList* list, int start, int stop){
+	int min = INT_MAX;
+	Node* result;
+	Node* first = list->head;
+	int count = 0;
+	while(first != NULL && count != start){ // set first to be the start node
+		first = first->next;
+		count++;
+	}
+	while(first != NULL && count != stop){ // while the stop node hasnt been reached, search for lowest h_score
+		if(min > first->board->h_score){
+			min = first->board->h_score;
+			result = first;
+		}
+		first = first->next;
+		count++;
+	}
+	return result;
+}
+
+/* Returns 0 if the given node is in the list and -1 otherwise */
+int in_list(LinkedList* list, Node* node){
+	if(list->head == NULL) return -1; // there are no nodes in the list
+	Node* tmp = list->head;
+	while(tmp != list->tail){
+		if(compare_boards(tmp->board->board, node->board->board) == 0){ // if boards are equal, return node
+			return 0;
+		}
+		tmp = tmp->next;
+	}
+	if(compare_boards(list->tail->board->board, node->board->board) == 0){
+		return 0;
+	}
+	return -1; 
+}
+
+
+/* Calculates the number of misplaced tiles on the board (not on their
+ * square in the goal, see init_packed_tables()) and returns the number.
+ * Can be added to h_score with manhattan distance for a faster but less
+ * optimal solution. (NOT USED) */
+int misplaced(Board *brd){
+	int sum = 0;      // holds the solution
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			int value = brd->board[i][j];
+			if(value != 0 && goal_index[value] != i * COLS + j) sum++;
+		}
+	}
+	return sum;
+}
+
+/* Calculates the Manhattan Distance for the given board and returns
+ * it in the form of an int.  The Manhattan Distance is the sum of
+ * the distances that all the tiles are misplaced on the board.
+ * (the 0 or empty tile is not counted)  The distances come from
+ * manhattan_table, so the goal is the one given to init_packed_tables() */
+int manhattan_distance(Board* brd){
+	int sum = 0;
+	//#pragma omp parallel for
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			sum += manhattan_table[brd->board[i][j]][i * COLS + j];
+		}
+	}
+	return sum;
+}
+
+/* Takes in a pointer to a board and returns an array of all possible
+ * actions that can be applied to the board. Allocates an array of length
+ * 4 that contains actions */
+Action* possible_actions(Board* brd){
+	int max_actions = 4; // there will be at most 4 possible moves
+	Action* poss_actions = malloc(max_actions * sizeof(Action));
+	assert(poss_actions);
+	int index = 0; // keeps track of number of assigned elements to array
+
+	for(int i = 0; i < max_actions; i++){ // initialize the array with NULL actions
+		poss_actions[i] = make_action(NULL, -1, -1, -1);
+	}
+	//#pragma omp parallel for
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			// check if you can move right
+			if(j != 3){
+				if(brd->board[i][j] != 0 && brd->board[i][j+1] == 0){
+					Action act = make_action("RIGHT", i, j, brd->board[i][j]);
+					poss_actions[index] = act;
+					index++;
+				}
+			}
+			// check if you can move left
+			if(j != 0){
+				if(brd->board[i][j] != 0 && brd->board[i][j-1] == 0){
+					Action act = make_action("LEFT", i, j, brd->board[i][j]);
+					poss_actions[index] = act;
+					index++;
+				}
+			}
+			// check if you can move up
+			if(i != 0){
+				if(brd->board[i][j] != 0 && brd->board[i-1][j] == 0){
+					Action act = make_action("UP", i, j, brd->board[i][j]);
+					poss_actions[index] = act;
+					index++;
+				}
+			}
+			// check if you can move down
+			if(i != 3){
+				if(brd->board[i][j] != 0 && brd->board[i+1][j] == 0){
+					Action act = make_action("DOWN", i, j, brd->board[i][j]);
+					poss_actions[index] = act;
+					index++;
+				}
+			}
+		}
+	}
+	return poss_actions;
+}
+
+/* Takes in an Action and a Board.  Returns a copy of
+ * the given board after the given Action is applied to it. 
+ * The Action results in the given tile being swapped with the
+ * tile in the given direction. Allocates space for a single Board
+ * (this is where the boards h_score is assigned) */
+Board* result(Action act, Board* brd) {
+	int move;                           // represents the tile to be moved  
+	Board* result = make_empty_board(); // allocate space for a new Board
+
+	//#pragma omp parallel for
+	for(int i = 0; i < ROWS; i++){      // copy the 2d array into the new board
+		for(int j = 0; j < COLS; j++){
+			result->board[i][j] = brd->board[i][j];
+		}
+	}
+	// set the parent board to the Board before action is applied
+	result->parent = brd;
+
+	if(strcmp(act.direction, "RIGHT") == 0){
+		move = result->board[act.row][act.col];
+		result->board[act.row][act.col] = result->board[act.row][act.col + 1];
+		result->board[act.row][act.col + 1] = move;
+	} else if(strcmp(act.direction, "LEFT") == 0){
+		move = result->board[act.row][act.col];
+		result->board[act.row][act.col] = result->board[act.row][act.col - 1];
+		result->board[act.row][act.col - 1] = move;
+	} else if(strcmp(act.direction, "UP") == 0){
+		move = result->board[act.row][act.col];
+		result->board[act.row][act.col] = result->board[act.row - 1][act.col];
+		result->board[act.row - 1][act.col] = move;
+	} else { // "DOWN"
+		move = result->board[act.row][act.col];
+		result->board[act.row][act.col] = result->board[act.row + 1][act.col];
+		result->board[act.row + 1][act.col] = move;
+	}
+	// set the h_score to the manhattan distance 
+	result->h_score = manhattan_distance(result);
+
+	return result;
+}
+
+/* Takes in a board and returns an array of boards that are the
+ * result of applying all possible actions to the given board. 
+ * Allocates and frees space for an array of size 4 containing 
+ * Board structs and allocates space for the LinkedList that 
+ * is returned */
+LinkedList* expand(Board* brd){
+	int index = 0;                               // current index of acts array
+	Action* acts = possible_actions(brd);        // list of possible actions to perform on brd
+	LinkedList* list = make_list();              // linkedlist to hold the boards after actions are performed
+
+	while(acts[index].direction != NULL){        // for each action, add resulting board to the end of list
+		Board* tmp = result(acts[index], brd);
+		Node* node = make_node(tmp);
+		push(list, node);
+		index++;
+		if(index == 4) break;
+	}
+	free(acts);
+	return list;
+}
+
+int find_parents(Board* brd){
+	int parents = 0;
+	Board * tmp = brd;
+	while(tmp->parent != NULL){
+		parents++;
+		tmp = tmp->parent;
+		//parents++;
+	}
+	return parents;
+}
+
+/* Packs the 2d array of a Board into 64 bits, 4 bits per tile */
+uint64_t pack_board(Board* brd){
+	uint64_t state = 0;
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			state |= (uint64_t)brd->board[i][j] << (4 * (i * COLS + j));
+		}
+	}
+	return state;
+}
+
+/* Unpacks a packed state into the 2d array of the given Board */
+void unpack_board(uint64_t state, Board* brd){
+	for(int i = 0; i < ROWS; i++){
+		for(int j = 0; j < COLS; j++){
+			brd->board[i][j] = (state >> (4 * (i * COLS + j))) & 0xF;
+		}
+	}
+}
+
+/* Returns the value of the tile at the given index of a packed state */
+int packed_tile(uint64_t state, int index){
+	return (state >> (4 * index)) & 0xF;
+}
+
+/* Returns the index of the 0 tile in a packed state */
+int packed_blank(uint64_t state){
+	for(int index = 0; index < TILES; index++){
+		if(packed_tile(state, index) == 0) return index;
+	}
+	return -1;
+}
+
+/* Fills 'table' with the distance of every tile value from its position
+ * in the given goal state, for every index on the board: table[value][index]
+ * like manhattan_table.  Used for manhattan_table itself and by
+ * frontier_search() and bidirectional_search() for their own targets */
+void build_goal_table(uint64_t goal, int table[TILES][TILES]){
+	for(int square = 0; square < TILES; square++){
+		int value = packed_tile(goal, square);
+		for(int index = 0; index < TILES; index++){
+			if(value == 0){
+				table[value][index] = 0; // the 0 tile is not counted
+			} else {
+				table[value][index] = abs(index / COLS - square / COLS) + abs(index % COLS - square % COLS);
+			}
+		}
+	}
+}
+
+/* Builds the tables every search scores and checks packed boards with for
+ * the given goal state: manhattan_table, goal_index and the mirroring
+ * tables of packed_transpose().  Must be called once before any packed
+ * board is scored, and before init_operator_table() and make_pattern_db(),
+ * which build on them */
+void init_packed_tables(uint64_t goal){
+	table_goal = goal;
+	build_goal_table(goal, manhattan_table);
+	for(int index = 0; index < TILES; index++){
+		goal_index[packed_tile(goal, index)] = index;
+		transpose_index[index] = (index % COLS) * ROWS + index / COLS;
+	}
+	for(int value = 0; value < TILES; value++){
+		transpose_tile[value] = packed_tile(goal, transpose_index[goal_index[value]]);
+	}
+	transpose_goal = transpose_index[goal_index[0]] == goal_index[0]; // the 0 tile must stay the 0 tile
+}
+
+/* Returns 1 if the 0 tile at index 'blank' can be moved in the given
+ * direction and 0 if it would leave the board */
+int move_possible(int blank, int move){
+	switch(move){
+		case MOVE_UP:    return blank >= COLS;
+		case MOVE_DOWN:  return blank < TILES - COLS;
+		case MOVE_LEFT:  return blank % COLS != 0;
+		default:         return blank % COLS != COLS - 1; // MOVE_RIGHT
+	}
+}
+
+/* Fills operator_delta_f, the change in f of every move for each tile that
+ * can slide into the 0 tile's place, used by the --partial expansion of
+ * a_star_search().  Needs manhattan_table, see init_packed_tables() */
+void init_operator_table(){
+	for(int tile = 0; tile < TILES; tile++){
+		for(int blank = 0; blank < TILES; blank++){
+			for(int move = 0; move < 4; move++){
+				if(!move_possible(blank, move)) continue;
+				int target = blank + move_delta[move]; // the tile slides from target to blank
+				operator_delta_f[tile][blank][move] = 1 + manhattan_table[tile][blank] - manhattan_table[tile][target];
+			}
+		}
+	}
+}
+
+/* Returns the state after the 0 tile at index 'blank' is moved in the given
+ * direction (the move must be possible).  The tile that is swapped with the
+ * 0 tile just has its 4 bits moved, since the 0 tile's bits are always 0 */
+uint64_t packed_move(uint64_t state, int blank, int move){
+	int target = blank + move_delta[move];
+	uint64_t tile = (state >> (4 * target)) & 0xF;
+	state &= ~((uint64_t)0xF << (4 * target));
+	return state | (tile << (4 * blank));
+}
+
+/* Change in the Manhattan Distance when the 0 tile at index 'blank' of the
+ * given state is moved in the given direction */
+int packed_manhattan_delta(uint64_t state, int blank, int move){
+	int target = blank + move_delta[move];
+	int tile = packed_tile(state, target);
+	return manhattan_table[tile][blank] - manhattan_table[tile][target];
+}
+
+/* Returns 1 if the goal can be reached from a packed state and 0 if not.
+ * Every move swaps the 0 tile with a neighbour, which flips both the parity
+ * of the permutation taking each tile to its goal square and the parity of
+ * the 0 tile's distance from its goal square, so the two parities must
+ * match, as they do in the goal */
+int packed_solvable(uint64_t state){
+	int seen = 0;                            // bit i is set once index i is in a counted cycle
+	int parity = 0;
+	for(int index = 0; index < TILES; index++){
+		int length = 0;
+		for(int i = index; !(seen & (1 << i)); i = goal_index[(state >> (4 * i)) & 0xF]){
+			seen |= 1 << i;
+			length++;
+		}
+		if(length > 0) parity ^= (length - 1) & 1; // a cycle of n indexes is n - 1 swaps
+	}
+	int blank = packed_blank(state);
+	int goal_blank = goal_index[0];
+	return parity == ((abs(blank / COLS - goal_blank / COLS) + abs(blank % COLS - goal_blank % COLS)) & 1);
+}
+
+/* Mirrors a packed state over the main diagonal, renaming each tile to the
+ * tile whose goal square is the mirror of its own.  The goal maps to itself,
+ * so a state and its mirror are solved by the same moves, mirrored with
+ * transpose_move[].  Only valid when transpose_goal is set, else the 0 tile
+ * would be renamed */
+uint64_t packed_transpose(uint64_t state){
+	uint64_t mirrored = 0;
+	for(int index = 0; index < TILES; index++){
+		uint64_t value = transpose_tile[(state >> (4 * index)) & 0xF];
+		mirrored |= value << (4 * transpose_index[index]);
+	}
+	return mirrored;
+}
+
+/* Stores in 'canonical' the lower of a packed state and its mirror (see
+ * packed_transpose()), so both give the same search and cache entries.
+ * Returns 1 if the mirror was taken, meaning the moves found for it must be
+ * mirrored back.  A goal whose 0 tile is off the diagonal has no mirror
+ * symmetry, then the state itself is taken */
+int canonical_state(uint64_t state, uint64_t* canonical){
+	*canonical = state;
+	if(!transpose_goal) return 0;
+	uint64_t mirrored = packed_transpose(state);
+	*canonical = mirrored < state ? mirrored : state;
+	return mirrored < state;
+}
+
+/* Calculates the Manhattan Distance of a packed state */
+int packed_manhattan(uint64_t state){
+	int sum = 0;
+	for(int index = 0; index < TILES; index++){
+		sum += manhattan_table[packed_tile(state, index)][index];
+	}
+	return sum;
+}
+
+/* Creates a PackedNode with the given values */
+PackedNode make_packed_node(uint64_t state, int g, int h, int move, int blank){
+	PackedNode node;
+	node.state = state;
+	node.g = g;
+	node.h = h;
+	node.move = (move & (MOVE_MASK | MOVE_ROOT)) | (blank << BLANK_SHIFT);
+	node.parent_rank = rank; // nodes are generated by the proc that holds their parent
+	node.key_offset = 0;
+	node.given = 0;
+	return node;
+}
+
+/* Returns the index of the 0 tile stored in a PackedNode */
+int node_blank(PackedNode* node){
+	return node->move >> BLANK_SHIFT;
+}
+
+/* Mixes the bits of a packed state into a hash value */
+uint64_t hash_state(uint64_t state){
+	state ^= state >> 33;
+	state *= 0xff51afd7ed558ccdULL;
+	state ^= state >> 33;
+	state *= 0xc4ceb9fe1a85ec53ULL;
+	state ^= state >> 33;
+	return state;
+}
+
+/* Counts 'bytes' more of the node tables and open lists against
+ * memory_budget.  If they do not fit, nothing is counted and 0 is
+ * returned, unless 'force' is set (the memory is needed to go on).
+ * memory_low is set once the budget is 90% used or an allocation did not
+ * fit, so the search can change strategy before it runs out.  Returns 1 if
+ * the bytes were counted */
+int memory_reserve(size_t bytes, int force){
+	size_t budget = memory_budget;
+	if(budget > 0 && memory_used + bytes > budget){
+		memory_low = 1;
+		if(!force) return 0;
+	}
+	memory_used += bytes;
+	if(budget > 0 && memory_used > budget / 10 * 9) memory_low = 1;
+	return 1;
+}
+
+/* Gives back bytes counted by memory_reserve() */
+void memory_release(size_t bytes){
+	memory_used -= bytes;
+}
+
+/* Returns the number of slots a search's NodeTable starts with: 1 << 16,
+ * or fewer under a small memory budget, so the first slots (which are not
+ * counted, see make_table()) take at most 1/16 of it */
+size_t initial_table_capacity(){
+	size_t capacity = 1 << 16;
+	while(memory_budget > 0 && capacity > 1024 && capacity * sizeof(PackedNode) > memory_budget / 16) capacity /= 2;
+	return capacity;
+}
+
+/* Records that the PackedNode of 'state' was added or changed, so the next
+ * checkpoint segment holds it.  Does nothing unless a_star_search() is
+ * writing checkpoints (changed_states is set) */
+void note_change(uint64_t state){
+	ChangeLog* log = changed_states;
+	if(log == NULL) return;
+	if(log->size == log->capacity){
+		log->capacity = log->capacity == 0 ? 1024 : log->capacity * 2;
+		log->states = realloc(log->states, log->capacity * sizeof(uint64_t));
+		assert(log->states);
+	}
+	log->states[log->size++] = state;
+}
+
+/* Allocates a NodeTable with the given number of slots (must be a power of 2),
+ * all of them empty.  Only the memory the table grows into is counted
+ * against the memory budget, not these first slots */
+NodeTable* make_table(size_t capacity){
+	NodeTable* table = malloc(sizeof(NodeTable));
+	assert(table);
+	table->slots = calloc(capacity, sizeof(PackedNode));
+	assert(table->slots);
+	table->capacity = capacity;
+	table->size = 0;
+	table->counted = 0;
+	return table;
+}
+
+/* Free memory allocated for the NodeTable */
+void destroy_table(NodeTable* table){
+	memory_release(table->counted);
+	free(table->slots);
+	free(table);
+}
+
+/* Removes every node from the table, keeping its slots for reuse */
+void clear_table(NodeTable* table){
+	memset(table->slots, 0, table->capacity * sizeof(PackedNode));
+	table->size = 0;
+}
+
+/* Returns the slot holding the given state, or the empty slot where
+ * it would be inserted if it is not in the table */
+PackedNode* table_slot(NodeTable* table, uint64_t state){
+	size_t mask = table->capacity - 1;
+	size_t index = hash_state(state) & mask;
+	while(table->slots[index].state != 0 && table->slots[index].state != state){
+		index = (index + 1) & mask; // linear probing
+	}
+	return &table->slots[index];
+}
+
+/* Returns the node in the table with the given state, or NULL if there is none */
+PackedNode* table_find(NodeTable* table, uint64_t state){
+	PackedNode* slot = table_slot(table, state);
+	return slot->state == 0 ? NULL : slot;
+}
+
+/* Starts loading the slot where the probe for a state begins, so that a
+ * table_find() or table_insert() of it issued a little later does not
+ * stall on a cache miss.  Only a hint, the table is not changed */
+void table_prefetch(NodeTable* table, uint64_t state){
+#ifdef __GNUC__
+	__builtin_prefetch(&table->slots[hash_state(state) & (table->capacity - 1)], 1);
+#endif
+}
+
+/* Doubles the number of slots in the table and reinserts every node.
+ * Unless 'force' is set, the table is left as it is if the new slots do not
+ * fit in the memory budget.  If they cannot be allocated the table is left
+ * as it is either way, and memory_low is set.  Pointers into the table are
+ * invalid afterwards.  Returns 1 if the table was grown */
+int table_grow(NodeTable* table, int force){
+	size_t bytes = table->capacity * 2 * sizeof(PackedNode);
+	if(!memory_reserve(bytes, force)) return 0;
+	PackedNode* slots = calloc(table->capacity * 2, sizeof(PackedNode));
+	if(slots == NULL){
+		memory_release(bytes);
+		memory_low = 1;
+		return 0;
+	}
+	PackedNode* old_slots = table->slots;
+	size_t old_capacity = table->capacity;
+	table->slots = slots;
+	table->capacity *= 2;
+	for(size_t i = 0; i < old_capacity; i++){
+		if(old_slots[i].state != 0){
+			*table_slot(table, old_slots[i].state) = old_slots[i];
+		}
+	}
+	free(old_slots);
+	memory_release(table->counted);
+	table->counted = bytes;
+	return 1;
+}
+
+/* Empties a slot of the table, moving back the nodes after it that were
+ * displaced past it by linear probing, so every node can still be found.
+ * Pointers into the table are invalid afterwards */
+void table_remove(NodeTable* table, PackedNode* slot){
+	size_t mask = table->capacity - 1;
+	size_t hole = slot - table->slots;
+	size_t index = hole;
+	while(1){
+		index = (index + 1) & mask;
+		PackedNode* node = &table->slots[index];
+		if(node->state == 0) break;
+		size_t home = hash_state(node->state) & mask;
+		if(((index - home) & mask) >= ((index - hole) & mask)){ // the hole is on the node's probe path
+			table->slots[hole] = *node;
+			hole = index;
+		}
+	}
+	memset(&table->slots[hole], 0, sizeof(PackedNode));
+	table->size--;
+}
+
+/* Adds a node whose state is not yet in the table and returns its slot.
+ * The table is grown before it becomes more than 3/4 full.  If that does
+ * not fit in the memory budget, the table keeps filling (memory_low tells
+ * the search to make room) and is only grown past the budget at 15/16
+ * full.  Returns NULL, with the node not added, if the table is full and
+ * could not be grown */
+PackedNode* table_insert(NodeTable* table, PackedNode node){
+	if((table->size + 1) * 4 > table->capacity * 3 && !table_grow(table, 0)){
+		if((table->size + 1) * 16 > table->capacity * 15 && !table_grow(table, 1) && table->size + 1 >= table->capacity) return NULL; // one slot is kept empty to end the probes
+	}
+	PackedNode* slot = table_slot(table, node.state);
+	*slot = node;
+	table->size++;
+	note_change(node.state);
+	return slot;
+}
+
+/* Allocates an empty OpenList with space for the given number of nodes */
+OpenList* make_open_list(size_t capacity){
+	OpenList* list = malloc(sizeof(OpenList));
+	assert(list);
+	list->nodes = malloc(capacity * sizeof(PackedNode));
+	assert(list->nodes);
+	memory_reserve(capacity * sizeof(PackedNode), 1);
+	list->size = 0;
+	list->capacity = capacity;
+	return list;
+}
+
+/* Free memory allocated for the OpenList */
+void destroy_open_list(OpenList* list){
+	memory_release(list->capacity * sizeof(PackedNode));
+	free(list->nodes);
+	free(list);
+}
+
+/* Add the given node to the end of the OpenList, doubling the array if it is full */
+void open_push(OpenList* list, PackedNode node){
+	if(list->size == list->capacity){
+		memory_reserve(list->capacity * sizeof(PackedNode), 1);
+		list->capacity *= 2;
+		list->nodes = realloc(list->nodes, list->capacity * sizeof(PackedNode));
+		assert(list->nodes);
+	}
+	list->nodes[list->size++] = node;
+}
+
+/* Removes and returns the node at the given index of the OpenList.  The last
+ * node is moved into its place so the array stays contiguous */
+PackedNode open_remove(OpenList* list, size_t index){
+	PackedNode node = list->nodes[index];
+	list->nodes[index] = list->nodes[--list->size];
+	return node;
+}
+
+/* Allocates an empty BucketQueue for priorities 0 to priorities-1 */
+BucketQueue* make_queue(int priorities){
+	BucketQueue* queue = malloc(sizeof(BucketQueue));
+	assert(queue);
+	queue->buckets = calloc(priorities, sizeof(OpenList*)); // buckets are allocated when first used
+	assert(queue->buckets);
+	queue->priorities = priorities;
+	queue->min = priorities;
+	queue->size = 0;
+	return queue;
+}
+
+/* Free memory allocated for the BucketQueue and its buckets */
+void destroy_queue(BucketQueue* queue){
+	for(int i = 0; i < queue->priorities; i++){
+		if(queue->buckets[i] != NULL) destroy_open_list(queue->buckets[i]);
+	}
+	free(queue->buckets);
+	free(queue);
+}
+
+/* Removes every node from the queue, keeping the buckets for reuse */
+void clear_queue(BucketQueue* queue){
+	for(int i = 0; i < queue->priorities; i++){
+		if(queue->buckets[i] != NULL) queue->buckets[i]->size = 0;
+	}
+	queue->min = queue->priorities;
+	queue->size = 0;
+}
+
+/* Adds a node to the bucket of the given priority.  A bucket starts with
+ * room for 16 nodes, so the many keys of a weighted search do not take
+ * much of a small memory budget */
+void queue_push(BucketQueue* queue, int priority, PackedNode node){
+	assert(priority >= 0 && priority < queue->priorities);
+	if(queue->buckets[priority] == NULL){
+		queue->buckets[priority] = make_open_list(16);
+	}
+	open_push(queue->buckets[priority], node);
+	if(priority < queue->min) queue->min = priority;
+	queue->size++;
+}
+
+/* Returns the lowest priority of any node in the queue, or
+ * queue->priorities if the queue is empty */
+int queue_min(BucketQueue* queue){
+	while(queue->min < queue->priorities && (queue->buckets[queue->min] == NULL || queue->buckets[queue->min]->size == 0)){
+		queue->min++;
+	}
+	return queue->min;
+}
+
+/* Removes a node with the lowest priority from the queue and stores it in
+ * 'node'.  The last node added to the bucket is removed first, which breaks
+ * ties in favor of the deepest node.  Returns the priority of the node, or
+ * -1 if the queue is empty */
+int queue_pop(BucketQueue* queue, PackedNode* node){
+	int priority = queue_min(queue);
+	if(priority == queue->priorities) return -1;
+	OpenList* bucket = queue->buckets[priority];
+	*node = open_remove(bucket, bucket->size - 1);
+	queue->size--;
+	return priority;
+}
+
+/* Makes and scores the child of the state in each of the IDA_LANES lanes:
+ * the 0 tile at index blanks[l] swaps with the tile at targets[l], like
+ * packed_move(), the child's Manhattan Distance is the parent's hs[l] plus
+ * the change, like packed_manhattan_delta(), and its f is that plus its
+ * depth gs[l].  Returns a mask with bit l set if the f of lane l is above
+ * bounds[l].  An idle lane must still hold indexes on the board, its
+ * results are ignored */
+int lane_children_scalar(const uint64_t* states, const int* blanks, const int* targets, const int* hs, const int* gs, const int* bounds, uint64_t* children, int* child_hs, int* fs){
+	int over = 0;
+	for(int l = 0; l < IDA_LANES; l++){
+		int tile = packed_tile(states[l], targets[l]);
+		children[l] = (states[l] & ~((uint64_t)0xF << (4 * targets[l]))) | ((uint64_t)tile << (4 * blanks[l]));
+		child_hs[l] = hs[l] + manhattan_table[tile][blanks[l]] - manhattan_table[tile][targets[l]];
+		fs[l] = gs[l] + child_hs[l];
+		if(fs[l] > bounds[l]) over |= 1 << l;
+	}
+	return over;
+}
+
+#ifdef LANE_AVX2
+/* lane_children_scalar() for the 4 lanes at once with AVX2: each 64-bit
+ * lane of the register holds one state, its tile is moved with variable
+ * shifts, the two manhattan_table entries of every lane are gathered, and
+ * h, f and the bound check are done on the 4 lanes of a 128-bit register */
+__attribute__((target("avx2")))
+int lane_children_avx2(const uint64_t* states, const int* blanks, const int* targets, const int* hs, const int* gs, const int* bounds, uint64_t* children, int* child_hs, int* fs){
+	__m256i state = _mm256_loadu_si256((const __m256i*)states);
+	__m128i blank = _mm_loadu_si128((const __m128i*)blanks);
+	__m128i target = _mm_loadu_si128((const __m128i*)targets);
+	__m256i blank_shift = _mm256_slli_epi64(_mm256_cvtepi32_epi64(blank), 2); // 4 bits per index
+	__m256i target_shift = _mm256_slli_epi64(_mm256_cvtepi32_epi64(target), 2);
+	__m256i nibble = _mm256_set1_epi64x(0xF);
+	__m256i tile = _mm256_and_si256(_mm256_srlv_epi64(state, target_shift), nibble);
+	__m256i cleared = _mm256_andnot_si256(_mm256_sllv_epi64(nibble, target_shift), state);
+	_mm256_storeu_si256((__m256i*)children, _mm256_or_si256(cleared, _mm256_sllv_epi64(tile, blank_shift)));
+	__m128i tiles = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(tile, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6))); // low half of each lane
+	__m128i row = _mm_slli_epi32(tiles, 4);  // TILES entries per tile in manhattan_table
+	__m128i to = _mm_i32gather_epi32(&manhattan_table[0][0], _mm_add_epi32(row, blank), 4);
+	__m128i from = _mm_i32gather_epi32(&manhattan_table[0][0], _mm_add_epi32(row, target), 4);
+	__m128i h = _mm_add_epi32(_mm_loadu_si128((const __m128i*)hs), _mm_sub_epi32(to, from));
+	__m128i f = _mm_add_epi32(_mm_loadu_si128((const __m128i*)gs), h);
+	_mm_storeu_si128((__m128i*)child_hs, h);
+	_mm_storeu_si128((__m128i*)fs, f);
+	__m128i over = _mm_cmpgt_epi32(f, _mm_loadu_si128((const __m128i*)bounds));
+	return _mm_movemask_ps(_mm_castsi128_ps(over)); // one bit per lane
+}
+#endif
+
+/* Returns the lane kernel lockstep_ida() uses: lane_children_avx2() when
+ * it is built and the CPU has AVX2, else lane_children_scalar() */
+LaneKernel lane_kernel(){
+#ifdef LANE_AVX2
+	if(__builtin_cpu_supports("avx2")) return lane_children_avx2;
+#endif
+	return lane_children_scalar;
+}
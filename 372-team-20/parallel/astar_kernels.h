@@ -0,0 +1,193 @@
+/* Declarations of the per-board kernels in astar_kernels.c, used by
+ * mpi_threads_astar.c and timed by bench_kernels.c */
+#ifndef ASTAR_KERNELS_H
+#define ASTAR_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ROWS 4                 // rows in the 4x4 grid representing the puzzle
+#define COLS 4                 // columns in the 4x4 grid representing the puzzle
+#define TILES (ROWS * COLS)    // number of tiles on the board, including the 0 tile
+
+#define MOVE_UP 0              // moves of the 0 tile, stored in 2 bits.  A move is undone
+#define MOVE_DOWN 1            // by the move with the low bit flipped (move ^ 1)
+#define MOVE_LEFT 2
+#define MOVE_RIGHT 3
+#define MOVE_MASK 0x3          // bits of PackedNode.move holding the move that generated the state
+#define MOVE_ROOT 0x4          // set in PackedNode.move for the start board, which has no parent
+#define MOVE_CLOSED 0x8        // set in PackedNode.move once the state has been explored
+#define BLANK_SHIFT 4          // bits 4-7 of PackedNode.move hold the index of the 0 tile
+
+#define IDA_LANES 4            // boards lockstep_ida() searches at once, one per 64-bit lane of an AVX2 register
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LANE_AVX2              // build lane_children_avx2(), used when the CPU has AVX2
+#endif
+
+typedef struct Board           // struct to hold a board and its associated values
+{
+	int board[ROWS][COLS];     // the 2d array representing the n-puzzle 
+	int h_score;               // the heuristic value given to the board
+	struct Board* parent;      // pointer to parent board if one exists (used to track sequence of moves taken)
+} Board;
+
+typedef struct Action          // struct to define a possible action that can be performed on a Board
+{
+	char* direction;           // the direction in which a board 'tile' can be shifted, possible
+			                   // values can be "up", "down", "left", or "right"
+	int row;                   // target row to move the tile
+	int col;                   // target column to move the tile
+	int value;                 // value of the tile to be moved
+} Action;                      // an Action is when you swap a numbered tile with the 0 tile
+
+typedef struct Node            // Nodes that will be in the linkedlist
+{
+	Board* board;              // Board struct
+	struct Node* next;         // next node in the list
+} Node;
+
+typedef struct LinkedList      // LinkedList to hold a list of Boards
+{
+	int size;                  // size of the list
+	Node* head;                // pointer to the first element in the list
+	Node* tail;                // pointer to the last element in the list
+} LinkedList;
+
+typedef struct PackedNode      // compact search node (16 bytes) used by a_star_search in place of Node + Board
+{
+	uint64_t state;            // the board packed 4 bits per tile, tile [i][j] is at bits 4*(i*COLS + j)
+	uint16_t g;                // number of moves from the start board (greedy paths can be longer than 255)
+	uint8_t h;                 // the heuristic value given to the board
+	uint8_t move;              // generating move, MOVE_ROOT and MOVE_CLOSED flags, and the index of the 0 tile
+	uint16_t parent_rank;      // rank of the proc whose table holds the parent (see trace_distributed_path())
+	uint8_t key_offset;        // with --partial, amount its priority in the open list is above node_key()
+	uint8_t given;             // 1 if closed because this proc gave it to another proc unexplored (split_open_list(), steal_give())
+} PackedNode;
+
+typedef struct NodeTable       // open addressing hash table holding every PackedNode generated by the search
+{
+	PackedNode* slots;         // the table, an empty slot has state 0 (0 is never a valid packed board)
+	size_t capacity;           // number of slots, always a power of 2
+	size_t size;               // number of occupied slots
+	size_t counted;            // bytes of 'slots' counted by memory_reserve(), 0 for the slots make_table() starts with
+} NodeTable;
+
+typedef struct OpenList        // unordered array of PackedNodes that have yet to be explored
+{
+	PackedNode* nodes;         // the array of nodes
+	size_t size;               // number of nodes in the array
+	size_t capacity;           // number of nodes the array has space for
+} OpenList;
+
+typedef struct BucketQueue     // open list ordered by a small integer priority, one OpenList per priority
+{
+	OpenList** buckets;        // nodes with each priority, NULL until the first one is added
+	int priorities;            // number of buckets
+	int min;                   // no bucket below this priority has nodes
+	size_t size;               // number of nodes in all buckets
+} BucketQueue;
+
+typedef struct ChangeLog       // states whose PackedNode was added or changed since the last checkpoint, see note_change()
+{
+	uint64_t* states;          // may hold a state more than once
+	size_t size;
+	size_t capacity;
+} ChangeLog;
+
+typedef int (*LaneKernel)(const uint64_t* states, const int* blanks, const int* targets, const int* hs, const int* gs, const int* bounds, uint64_t* children, int* child_hs, int* fs); // see lane_children_scalar()
+
+extern int nprocs, rank;       // number of processes and rank of the proc
+extern int initial_arr_size;   // initial size of the arrays allocated in the A* search
+extern size_t memory_budget;   // bytes the NodeTables and open lists may take on each proc, 0 for no limit (--memory)
+extern size_t memory_used;     // bytes held by the NodeTables and OpenLists of this proc, see memory_reserve()
+extern int memory_low;         // 1 once memory_used has come near memory_budget
+extern ChangeLog* changed_states; // where note_change() records states while a_star_search() writes checkpoints
+extern int manhattan_table[TILES][TILES]; // manhattan_table[value][index] is the distance of tile 'value' at 'index' from its goal
+extern int move_delta[4];      // change in the index of the 0 tile for each move
+extern int8_t operator_delta_f[TILES][TILES][4]; // [tile][index of the 0 tile][move] is the change in f of 'move', see init_operator_table()
+extern int transpose_index[TILES]; // transpose_index[index] is the index mirrored over the main diagonal
+extern int transpose_tile[TILES]; // transpose_tile[value] is the tile whose goal square is the mirror of the goal square of 'value'
+extern int transpose_goal;     // 1 if the goal's 0 tile is on the main diagonal, so a state can be mirrored (see packed_transpose())
+extern uint64_t table_goal;    // the goal state manhattan_table and the other goal tables are built for
+extern int goal_index[TILES];  // goal_index[value] is the index of tile 'value' in table_goal
+
+/* Board and LinkedList functions of the original search */
+Board* make_empty_board();
+void destroy_board(Board* brd);
+void print_board(Board* brd);
+int compare_boards(int x[ROWS][COLS], int y[ROWS][COLS]);
+void copy_board(Board* a, Board* b);
+Action make_action(char* direction, int row, int col, int value);
+void print_action(Action act);
+Node* make_node(Board* brd);
+void destroy_node(Node* node);
+LinkedList* make_list();
+void free_list(LinkedList* list);
+void print_list(LinkedList* list);
+void push(LinkedList* ll, Node* node);
+void pop(LinkedList* list);
+void remove_node(LinkedList* list, Node* node);
+Board** list_to_array(LinkedList* list);
+Board** double_array(Board** old_array, int array_size);
+Node* find_min_h(LinkedList* list);
+Node* find_min_h_parallel(LinkedList* list, int start, int stop);
+int in_list(LinkedList* list, Node* node);
+int misplaced(Board *brd);
+int manhattan_distance(Board* brd);
+Action* possible_actions(Board* brd);
+Board* result(Action act, Board* brd);
+LinkedList* expand(Board* brd);
+int find_parents(Board* brd);
+
+/* Packed boards, the goal tables and moves */
+uint64_t pack_board(Board* brd);
+void unpack_board(uint64_t state, Board* brd);
+int packed_tile(uint64_t state, int index);
+int packed_blank(uint64_t state);
+void build_goal_table(uint64_t goal, int table[TILES][TILES]);
+void init_packed_tables(uint64_t goal);
+int move_possible(int blank, int move);
+void init_operator_table();
+uint64_t packed_move(uint64_t state, int blank, int move);
+int packed_manhattan_delta(uint64_t state, int blank, int move);
+int packed_solvable(uint64_t state);
+uint64_t packed_transpose(uint64_t state);
+int canonical_state(uint64_t state, uint64_t* canonical);
+int packed_manhattan(uint64_t state);
+
+/* PackedNodes, the memory budget and the tables and queues holding them */
+PackedNode make_packed_node(uint64_t state, int g, int h, int move, int blank);
+int node_blank(PackedNode* node);
+uint64_t hash_state(uint64_t state);
+int memory_reserve(size_t bytes, int force);
+void memory_release(size_t bytes);
+size_t initial_table_capacity();
+void note_change(uint64_t state);
+NodeTable* make_table(size_t capacity);
+void destroy_table(NodeTable* table);
+void clear_table(NodeTable* table);
+PackedNode* table_slot(NodeTable* table, uint64_t state);
+PackedNode* table_find(NodeTable* table, uint64_t state);
+void table_prefetch(NodeTable* table, uint64_t state);
+int table_grow(NodeTable* table, int force);
+void table_remove(NodeTable* table, PackedNode* slot);
+PackedNode* table_insert(NodeTable* table, PackedNode node);
+OpenList* make_open_list(size_t capacity);
+void destroy_open_list(OpenList* list);
+void open_push(OpenList* list, PackedNode node);
+PackedNode open_remove(OpenList* list, size_t index);
+BucketQueue* make_queue(int priorities);
+void destroy_queue(BucketQueue* queue);
+void clear_queue(BucketQueue* queue);
+void queue_push(BucketQueue* queue, int priority, PackedNode node);
+int queue_min(BucketQueue* queue);
+int queue_pop(BucketQueue* queue, PackedNode* node);
+
+/* Lane kernels of lockstep_ida() */
+int lane_children_scalar(const uint64_t* states, const int* blanks, const int* targets, const int* hs, const int* gs, const int* bounds, uint64_t* children, int* child_hs, int* fs);
+#ifdef LANE_AVX2
+int lane_children_avx2(const uint64_t* states, const int* blanks, const int* targets, const int* hs, const int* gs, const int* bounds, uint64_t* children, int* child_hs, int* fs);
+#endif
+LaneKernel lane_kernel();
+
+#endif
@@ -0,0 +1,362 @@
+/* Microbenchmarks for the kernels that run once or more per generated
+ * board: the Board + LinkedList functions of the original search and the
+ * PackedNode alternatives used by a_star_search().  Each kernel is timed
+ * in ns/op over boards taken from random walks of several depths from the
+ * goal, after a warm-up pass, over a number of repetitions, and printed
+ * with the min, median, mean and standard deviation of the repetitions.
+ * Kernels that do the same job are printed next to each other.
+ *
+ * Build with "make bench_kernels.exec" and run it directly (no mpirun):
+ *     ./bench_kernels.exec [--states N] [--reps N] [--list N] [--seed S]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <math.h>
+#include "astar_kernels.h"
+
+typedef struct BenchData       // the boards a kernel is timed on, all from walks of one depth
+{
+	int count;                 // number of boards
+	Board** boards;            // the boards, h_score set
+	uint64_t* states;          // the same boards packed
+	int* blanks;               // index of the 0 tile of each state
+	int* moves;                // a possible move of the 0 tile for each state
+	Action* actions;           // the Action equivalent to moves[i] for each board
+	LinkedList* list;          // the first 'list_size' boards, for the linear open/closed list kernels
+	NodeTable* table;          // every state, for the hashed lookups
+	BucketQueue* queue;        // every state ordered by h, for the bucket queue kernels
+} BenchData;
+
+typedef long (*Kernel)(BenchData* data, int i); // does one op on board i, returns a value so it is not optimized away
+
+int bench_depths[] = { 10, 40, 160 }; // lengths of the random walks
+int bench_states = 4096;       // boards per depth
+int bench_reps = 15;           // timed passes over the boards per kernel
+int bench_list = 1000;         // boards in the LinkedList used by in_list() and find_min_h()
+unsigned int bench_seed = 12345; // seed of the random walks
+volatile long bench_sink;      // results of the kernels
+
+/* Returns the time in nanoseconds */
+double now_ns(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Returns a state 'depth' random moves away from the goal, never undoing the previous move */
+uint64_t random_walk(int depth, unsigned int* seed){
+	uint64_t state = table_goal;             // see init_packed_tables()
+	int previous = -1;
+	for(int i = 0; i < depth; i++){
+		int blank = packed_blank(state);
+		int move;
+		do {
+			move = rand_r(seed) % 4;
+		} while(!move_possible(blank, move) || move == (previous ^ 1));
+		state = packed_move(state, blank, move);
+		previous = move;
+	}
+	return state;
+}
+
+/* Returns the Action that moves the tile next to the 0 tile into its place, the same as 'move' of the 0 tile */
+Action move_action(Board* brd, int blank, int move){
+	char* names[4] = { "DOWN", "UP", "RIGHT", "LEFT" }; // the tile moves the other way
+	int index = blank + move_delta[move];
+	return make_action(names[move], index / COLS, index % COLS, brd->board[index / COLS][index % COLS]);
+}
+
+/* Builds the boards and the lists and tables of one depth */
+BenchData* make_bench_data(int depth, unsigned int* seed){
+	BenchData* data = malloc(sizeof(BenchData));
+	assert(data);
+	data->count = bench_states;
+	data->boards = malloc(data->count * sizeof(Board*));
+	data->states = malloc(data->count * sizeof(uint64_t));
+	data->blanks = malloc(data->count * sizeof(int));
+	data->moves = malloc(data->count * sizeof(int));
+	data->actions = malloc(data->count * sizeof(Action));
+	assert(data->boards && data->states && data->blanks && data->moves && data->actions);
+	data->list = make_list();
+	data->table = make_table(1 << 16);
+	data->queue = make_queue(UINT8_MAX + 1); // one bucket per h, which is stored in a byte
+	for(int i = 0; i < data->count; i++){
+		uint64_t state = random_walk(depth, seed);
+		data->states[i] = state;
+		data->blanks[i] = packed_blank(state);
+		do {
+			data->moves[i] = rand_r(seed) % 4;
+		} while(!move_possible(data->blanks[i], data->moves[i]));
+		data->boards[i] = make_empty_board();
+		unpack_board(state, data->boards[i]);
+		data->boards[i]->h_score = manhattan_distance(data->boards[i]);
+		data->actions[i] = move_action(data->boards[i], data->blanks[i], data->moves[i]);
+		if(i < bench_list){
+			Board* copy = make_empty_board();
+			copy_board(data->boards[i], copy);
+			push(data->list, make_node(copy));
+		}
+		PackedNode node = make_packed_node(state, depth, data->boards[i]->h_score, MOVE_ROOT, data->blanks[i]);
+		if(table_find(data->table, state) == NULL) table_insert(data->table, node);
+		queue_push(data->queue, node.h, node);
+	}
+	return data;
+}
+
+/* Frees every node of a list and its board.  free_list() leaves the
+ * tail's board allocated, which would add up over millions of calls */
+void destroy_list(LinkedList* list){
+	Node* node = list->head;
+	while(node != NULL){
+		Node* next = node->next;
+		destroy_node(node);
+		node = next;
+	}
+	free(list);
+}
+
+/* Frees the boards, lists and tables of one depth */
+void destroy_bench_data(BenchData* data){
+	for(int i = 0; i < data->count; i++) destroy_board(data->boards[i]);
+	destroy_list(data->list);
+	destroy_table(data->table);
+	destroy_queue(data->queue);
+	free(data->boards);
+	free(data->states);
+	free(data->blanks);
+	free(data->moves);
+	free(data->actions);
+	free(data);
+}
+
+long k_compare_boards(BenchData* d, int i){
+	return compare_boards(d->boards[i]->board, d->boards[(i + 1) % d->count]->board);
+}
+
+long k_compare_packed(BenchData* d, int i){
+	return d->states[i] == d->states[(i + 1) % d->count];
+}
+
+long k_copy_board(BenchData* d, int i){
+	Board copy;
+	copy_board(d->boards[i], &copy);
+	return copy.board[0][0];
+}
+
+long k_copy_packed(BenchData* d, int i){
+	PackedNode copy = make_packed_node(d->states[i], 0, 0, MOVE_ROOT, d->blanks[i]);
+	return (long)copy.state;
+}
+
+long k_manhattan_distance(BenchData* d, int i){
+	return manhattan_distance(d->boards[i]);
+}
+
+long k_packed_manhattan(BenchData* d, int i){
+	return packed_manhattan(d->states[i]);
+}
+
+long k_manhattan_delta(BenchData* d, int i){
+	return packed_manhattan_delta(d->states[i], d->blanks[i], d->moves[i]);
+}
+
+long k_possible_actions(BenchData* d, int i){
+	Action* acts = possible_actions(d->boards[i]);
+	long row = acts[0].row;
+	free(acts);
+	return row;
+}
+
+long k_move_possible(BenchData* d, int i){
+	int blank = packed_blank(d->states[i]);
+	long count = 0;
+	for(int move = 0; move < 4; move++) count += move_possible(blank, move);
+	return count;
+}
+
+long k_result(BenchData* d, int i){
+	Board* child = result(d->actions[i], d->boards[i]);
+	long h = child->h_score;
+	destroy_board(child);
+	return h;
+}
+
+long k_packed_move(BenchData* d, int i){
+	uint64_t child = packed_move(d->states[i], d->blanks[i], d->moves[i]);
+	return d->boards[i]->h_score + packed_manhattan_delta(d->states[i], d->blanks[i], d->moves[i]) + (long)(child & 0xF);
+}
+
+/* Makes and scores one child of each of the IDA_LANES boards from board i
+ * on with a lane kernel of lockstep_ida(), returns the sum of the child
+ * heuristics plus the bound mask */
+long lane_children_op(LaneKernel kernel, BenchData* d, int i){
+	uint64_t states[IDA_LANES], children[IDA_LANES];
+	int blanks[IDA_LANES], targets[IDA_LANES], hs[IDA_LANES], gs[IDA_LANES], bounds[IDA_LANES], child_hs[IDA_LANES], fs[IDA_LANES];
+	for(int l = 0; l < IDA_LANES; l++){
+		int board = (i + l) % d->count;
+		states[l] = d->states[board];
+		blanks[l] = d->blanks[board];
+		targets[l] = blanks[l] + move_delta[d->moves[board]];
+		hs[l] = d->boards[board]->h_score;
+		gs[l] = 1;
+		bounds[l] = hs[l];                   // about half the children are over
+	}
+	long sum = kernel(states, blanks, targets, hs, gs, bounds, children, child_hs, fs);
+	for(int l = 0; l < IDA_LANES; l++) sum += child_hs[l] + (long)(children[l] & 0xFF);
+	return sum;
+}
+
+long k_lane_children_scalar(BenchData* d, int i){
+	return lane_children_op(lane_children_scalar, d, i);
+}
+
+long k_lane_kernel(BenchData* d, int i){
+	static LaneKernel kernel = NULL;
+	if(kernel == NULL) kernel = lane_kernel();
+	return lane_children_op(kernel, d, i);
+}
+
+long k_expand(BenchData* d, int i){
+	LinkedList* children = expand(d->boards[i]);
+	long size = children->size;
+	destroy_list(children);
+	return size;
+}
+
+long k_expand_packed(BenchData* d, int i){
+	PackedNode children[4];
+	int blank = packed_blank(d->states[i]);
+	int h = d->boards[i]->h_score;
+	long count = 0;
+	for(int move = 0; move < 4; move++){
+		if(!move_possible(blank, move)) continue;
+		uint64_t state = packed_move(d->states[i], blank, move);
+		children[count++] = make_packed_node(state, 1, h + packed_manhattan_delta(d->states[i], blank, move), move, blank + move_delta[move]);
+	}
+	return count + children[0].h;
+}
+
+long k_in_list(BenchData* d, int i){
+	Node node = { d->boards[i], NULL };
+	return in_list(d->list, &node);
+}
+
+long k_table_find(BenchData* d, int i){
+	return table_find(d->table, d->states[i]) != NULL;
+}
+
+long k_find_min_h(BenchData* d, int i){
+	return find_min_h(d->list)->board->h_score;
+}
+
+long k_queue_pop_push(BenchData* d, int i){
+	PackedNode node;
+	int priority = queue_pop(d->queue, &node);
+	queue_push(d->queue, priority, node);
+	return priority;
+}
+
+/* Compares two doubles for qsort */
+int compare_doubles(const void* a, const void* b){
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+/* Times one kernel on every board of 'data': one untimed warm-up pass,
+ * then bench_reps timed passes, and prints the ns/op statistics */
+void bench(char* name, Kernel kernel, BenchData* data, int depth){
+	double* ns = malloc(bench_reps * sizeof(double));
+	assert(ns);
+	long sink = 0;
+	for(int i = 0; i < data->count; i++) sink += kernel(data, i);
+	for(int r = 0; r < bench_reps; r++){
+		double begin = now_ns();
+		for(int i = 0; i < data->count; i++) sink += kernel(data, i);
+		ns[r] = (now_ns() - begin) / data->count;
+	}
+	bench_sink = sink;
+	qsort(ns, bench_reps, sizeof(double), compare_doubles);
+	double mean = 0, var = 0;
+	for(int r = 0; r < bench_reps; r++) mean += ns[r];
+	mean /= bench_reps;
+	for(int r = 0; r < bench_reps; r++) var += (ns[r] - mean) * (ns[r] - mean);
+	double stddev = bench_reps > 1 ? sqrt(var / (bench_reps - 1)) : 0;
+	printf("%-22s %5d %10.1f %10.1f %10.1f %10.1f\n", name, depth, ns[0], ns[bench_reps / 2], mean, stddev);
+	free(ns);
+}
+
+/* Sets the bench_ settings from the command line.  Returns 0 on success
+ * and -1 on a bad argument */
+int parse_bench_args(int argc, char* argv[]){
+	for(int i = 1; i < argc; i++){
+		int has_value = i + 1 < argc;
+		if(strcmp(argv[i], "--states") == 0 && has_value){
+			bench_states = atoi(argv[++i]);
+			if(bench_states < 2) return -1;
+		} else if(strcmp(argv[i], "--reps") == 0 && has_value){
+			bench_reps = atoi(argv[++i]);
+			if(bench_reps < 1) return -1;
+		} else if(strcmp(argv[i], "--list") == 0 && has_value){
+			bench_list = atoi(argv[++i]);
+			if(bench_list < 2) return -1;
+		} else if(strcmp(argv[i], "--seed") == 0 && has_value){
+			bench_seed = strtoul(argv[++i], NULL, 10);
+		} else {
+			return -1;
+		}
+	}
+	if(bench_list > bench_states) bench_list = bench_states;
+	return 0;
+}
+
+int main(int argc, char* argv[]){
+	struct { char* name; Kernel kernel; } kernels[] = { // each original kernel followed by its packed alternative
+		{ "compare_boards", k_compare_boards },
+		{ "  state ==", k_compare_packed },
+		{ "copy_board", k_copy_board },
+		{ "  make_packed_node", k_copy_packed },
+		{ "manhattan_distance", k_manhattan_distance },
+		{ "  packed_manhattan", k_packed_manhattan },
+		{ "  manhattan_delta", k_manhattan_delta },
+		{ "possible_actions", k_possible_actions },
+		{ "  move_possible x4", k_move_possible },
+		{ "result", k_result },
+		{ "  packed_move + h", k_packed_move },
+		{ "  lane_children x4", k_lane_children_scalar },
+		{ "  lane_kernel() x4", k_lane_kernel },
+		{ "expand", k_expand },
+		{ "  packed expand", k_expand_packed },
+		{ "in_list", k_in_list },
+		{ "  table_find", k_table_find },
+		{ "find_min_h", k_find_min_h },
+		{ "  queue_pop + push", k_queue_pop_push },
+	};
+	int count = sizeof(kernels) / sizeof(kernels[0]);
+	int depths = sizeof(bench_depths) / sizeof(int);
+
+	if(parse_bench_args(argc, argv) != 0){
+		printf("usage: %s [--states N] [--reps N] [--list N] [--seed S]\n", argv[0]);
+		return 1;
+	}
+	init_packed_tables(0xFEDCBA9876543210ull); // the default goal, tile v at index v
+	init_operator_table();
+
+	BenchData** data = malloc(depths * sizeof(BenchData*));
+	assert(data);
+	unsigned int seed = bench_seed;
+	for(int d = 0; d < depths; d++) data[d] = make_bench_data(bench_depths[d], &seed);
+
+	printf("%d boards per depth, %d repetitions, %d boards in the linked list\n", bench_states, bench_reps, bench_list);
+	printf("%-22s %5s %10s %10s %10s %10s\n", "kernel (ns/op)", "depth", "min", "median", "mean", "stddev");
+	for(int k = 0; k < count; k++){
+		for(int d = 0; d < depths; d++) bench(kernels[k].name, kernels[k].kernel, data[d], bench_depths[d]);
+	}
+
+	for(int d = 0; d < depths; d++) destroy_bench_data(data[d]);
+	free(data);
+	return 0;
+}
@@ -0,0 +1,9 @@
+#!/bin/bash
+#SBATCH -p RM
+#SBATCH -t 00:05:00
+#SBATCH --nodes=1
+#SBATCH --ntasks=2
+#SBATCH --ntasks-per-socket=1
+#SBATCH --cpus-per-task=14
+set -x
+OMP_NUM_THREADS=14 OMP_PROC_BIND=close OMP_PLACES=cores mpirun -np $SLURM_NTASKS --map-by ppr:1:socket:PE=14 --bind-to core ./a.exec --pdb --numa
@@ -5,4 +5,4 @@
 #SBATCH --ntasks=3
 #SBATCH --cpus-per-task=28
 set -x
-OMP_NUM_THREADS=28 mpirun -np $SLURM_NTASKS ./a.exec
+OMP_NUM_THREADS=28 OMP_PROC_BIND=close OMP_PLACES=cores mpirun -np $SLURM_NTASKS --bind-to none ./a.exec
@@ -5,607 +5,4008 @@
 #include <time.h>
 #include <mpi.h>
 #include <limits.h>
+#include <float.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include "astar_kernels.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-#define ROWS 4                 // rows in the 4x4 grid representing the puzzle
-#define COLS 4                 // columns in the 4x4 grid representing the puzzle
-int nprocs, rank;              // number of processes and rank of the proc
-int initial_arr_size = 15000;  // initial size of the arrays allocated in the A* search
+#define MODE_ASTAR 0           // a_star_search(), open and closed sets in memory
+#define MODE_DISK 1            // disk_a_star_search(), open and closed sets in files under options.disk_dir
+#define MODE_FRONTIER 2        // frontier_search(), only the current and next layers in memory
+#define MODE_BIDIRECTIONAL 3   // bidirectional_search(), forward and backward searches that meet in the middle
+#define MODE_ARA 4             // ara_star_search(), anytime weighted A* that tightens its bound until a deadline
+#define MODE_SERVE 5           // serve(), a solver service answering requests on a UNIX domain socket
+#define MODE_PORTFOLIO 6       // portfolio_search(), every proc races a different search on the same board
+#define MODE_IDA 7             // ida_star_search(), IDA* with a transposition table and FSM move pruning
+#define QUEUE_PRIORITIES 512   // number of priorities the BucketQueues of bidirectional_search() have
+#define HIST_VALUES (MAX_PATH + DISK_MAX_H) // number of f or g values a Histogram counts separately
+#define PDB_PATTERNS 3         // number of disjoint tile patterns in the pattern database
+#define PDB_MAX_TILES 6        // most tiles in one pattern, its table has 16^6 entries
+#define TAG_INCUMBENT 1        // MPI tag of the messages that share a new best solution cost
+#define TAG_TRACE 2            // MPI tag of the token passed between procs by trace_distributed_path()
+#define TAG_SEGMENT 3          // MPI tag of the moves sent to proc 0 by trace_distributed_path()
+#define TAG_DONE 4             // MPI tag telling a proc trace_distributed_path() is done
+#define TAG_STEAL_REQUEST 5    // MPI tag of a request for open nodes from a proc that is low on work
+#define TAG_STEAL_REPLY 6      // MPI tag of the open nodes (maybe none) given in reply to a request
+#define TAG_SERVE 7            // MPI tag of a ServeResult sent to proc 0 by serve_batch()
+#define TAG_CANCEL 8           // MPI tag telling the other procs of portfolio_search() to stop
+#define TAG_RACE 9             // MPI tag of the winning ServeResult sent to proc 0 by portfolio_search()
+#define TAG_SERVE_WORK 10      // MPI tag of the board indexes proc 0 hands a proc in serve_batch() (none: batch done)
+
+#define SERVE_MAX_CLIENTS 64   // most clients connected to serve() at once
+#define SERVE_LINE 256         // longest request line serve() accepts
+#define FSM_DEPTH 6            // longest move sequences init_move_fsm() compares to find duplicates
+#define FSM_MAX_NODES 256      // most nodes of the move pruning FSM
+#define FSM_GRID 13            // width of the open board init_move_fsm() makes moves on, room for FSM_DEPTH moves every way
+#define PREFETCH_DISTANCE 8    // how many children ahead of its insertions expand_batch() prefetches table slots
+#define CLOSED_PROBES 8        // slots of the distributed closed set tried for a state before it is explored anyway
+#define CLOSED_DEPTH (1 << 16) // above any PackedNode.g, closed_claim() stores CLOSED_DEPTH - g
+#define RACE_POLL 1024         // nodes a portfolio_search() strategy explores between checks for a cancel message
+#define CACHE_WAYS 8           // entries per set of the result cache, the least recently used one is evicted
+#define CACHE_MAGIC 0x32454843414353ull // "SCACHE2", first field of a result cache file
+#define WEIGHT_SCALE 10        // heuristic weights are used in steps of 1/WEIGHT_SCALE (see node_key())
+#define MAX_PATH 1024          // longest path (g) a BucketQueue ordered by node_key() has buckets for
+#define MAX_SEGMENTS (1 << 16) // most segments trace_distributed_path() takes, their index is sent in 2 bytes
+#define CHECKPOINT_MAGIC 0x33544E494F504B43ull // "CKPOINT3", first field of each segment of a checkpoint file
+#define MANIFEST_MAGIC 0x3146494E414D4B43ull   // "CKMANIF1", first field of the checkpoint manifest
+#define DISK_MAX_G 256         // number of g values (moves from the start) MODE_DISK has buckets for
+#define DISK_MAX_H 256         // number of h values MODE_DISK has buckets for (h is stored in a byte)
 double start;                  // time A* seach begins
 
-typedef struct Board           // struct to hold a board and its associated values
+typedef struct Options         // settings given on the command line, see parse_args()
+{
+	int mode;                  // which search to run, one of the MODE_ values
+	char* disk_dir;            // directory for the bucket files of MODE_DISK
+	size_t disk_buffer;        // number of nodes in each I/O buffer and sorted run of MODE_DISK
+	double weight;             // w for weighted A* (priority g + w*h), 0 for the original priority h
+	double ara_step;           // amount MODE_ARA lowers the weight by after each solution
+	double deadline;           // seconds MODE_ARA may run for, 0 for no limit
+	int optimal;               // 1 if a_star_search() must prove its solution is optimal before it stops
+	int sync_interval;         // number of iterations between the MPI_Allreduce checks in a_star_search()
+	int use_pdb;               // 1 to use the pattern database heuristic in a_star_search() and ara_star_search()
+	char* pdb_file;            // file the pattern database is loaded from or saved to, NULL for none
+	int steal_low;             // a proc with fewer open nodes than this asks another for work, 0 to never steal
+	int steal_batch;           // most open nodes given away in reply to one request for work
+	int numa;                  // 1 to keep one copy of the shared tables per NUMA domain (socket) instead of per node
+	char* checkpoint;          // checkpoint files are this prefix followed by .<rank>, NULL for no checkpoints
+	long checkpoint_every;     // iterations between checkpoints
+	int restart;               // 1 to resume a_star_search() from the checkpoint files
+	int partial;               // 1 for enhanced partial expansion (EPEA*) in a_star_search()
+	int batch;                 // number of open nodes a_star_search() explores per iteration
+	char* serve_path;          // UNIX domain socket serve() listens on
+	int serve_batch;           // most requests solved in one batch by serve()
+	long serve_limit;          // most nodes serve() explores for one request before giving up
+	char* cache_file;          // file holding serve()'s result cache, NULL for no cache
+	long cache_entries;        // number of states the result cache has room for
+	long tt_entries;           // entries of the IDA* transposition table, 0 for none
+	int fsm;                   // 1 to prune duplicate move sequences in IDA* with the FSM
+	long closed_entries;       // states each proc's segment of the distributed closed set holds, 0 for none
+	int lookahead;             // depth of the AL* probes below each explored node, 0 for none
+	int lockstep;              // 1 to solve --serve batches with lockstep_ida(), IDA_LANES boards at a time
+} Options;
+
+Options options = {            // the defaults, every field not named here is 0 or NULL
+	.mode = MODE_ASTAR,
+	.disk_dir = "/tmp",
+	.disk_buffer = 1 << 16,
+	.ara_step = 0.5,
+	.sync_interval = 1,
+	.steal_batch = 16,
+	.checkpoint_every = 1 << 20,
+	.batch = 1,
+	.serve_batch = 64,
+	.serve_limit = 1 << 22,
+	.cache_entries = 1 << 20,
+	.tt_entries = 1 << 20,
+	.fsm = 1,
+};
+
+typedef struct DiskStream      // sequential reader or writer of a file of PackedNodes, double buffered
+{
+	FILE* file;                // the file being read or written
+	int writing;               // 1 for a writer, 0 for a reader
+	PackedNode* buffers[2];    // the search uses one buffer while 'thread' reads or writes the other
+	size_t counts[2];          // number of nodes in each buffer
+	size_t capacity;           // number of nodes each buffer has space for
+	size_t pos;                // next node to be read from the active buffer
+	int active;                // index of the buffer used by the search
+	int io_buffer;             // index of the buffer 'thread' is reading or writing
+	int busy;                  // 1 while 'thread' is running
+	int failed;                // 1 once 'thread' could not read or write a whole buffer
+	pthread_t thread;          // background thread doing the I/O
+} DiskStream;
+
+typedef struct FrontierNode    // node of one layer in frontier_search(), there is no parent or closed list
+{
+	uint64_t state;            // the board packed 4 bits per tile, like PackedNode
+	uint64_t relay;            // state the node's path passes through at the relay depth, 0 above it
+	uint8_t h;                 // the heuristic value given to the board
+	uint8_t used;              // used-operator bits, bit 'move' is set if the move leads back to a parent
+	uint8_t blank;             // index of the 0 tile
+} FrontierNode;
+
+typedef struct FrontierLayer   // array of every FrontierNode at one depth
+{
+	FrontierNode* nodes;       // the array of nodes
+	size_t size;               // number of nodes in the array
+	size_t capacity;           // number of nodes the array has space for
+} FrontierLayer;
+
+typedef struct Histogram       // number of open nodes with each f or g value, to find the minimum quickly
+{
+	long count[HIST_VALUES];   // count[v] is the number of open nodes with value v (larger values are counted at the top)
+	int min;                   // lowest value with a count above 0, HIST_VALUES if there is none
+} Histogram;
+
+typedef struct Incumbent       // cost of the best solution, shared between the procs by a_star_search()
+{
+	int cost;                  // cost of the best solution known to this proc, INT_MAX if there is none
+	int* values;               // send buffers, values[r] is the last cost sent to proc r
+	int* sent;                 // sent[r] is the number of costs sent to proc r
+	MPI_Request* requests;     // requests[r] is the last send to proc r
+	int* owed;                 // owed[r] is 1 if a lower cost waits for the last send to proc r to complete
+	int nprocs;
+	int received;              // number of costs received from the other procs
+} Incumbent;
+
+typedef struct SearchSide      // one direction of bidirectional_search()
+{
+	NodeTable* table;          // every state reached in this direction
+	BucketQueue* open;         // open nodes ordered by max(f, 2g)
+	Histogram f_hist;          // f values of the open nodes
+	Histogram g_hist;          // g values of the open nodes
+	int (*h_table)[TILES];     // heuristic table toward this direction's target (see build_goal_table())
+} SearchSide;
+
+typedef struct PatternDB       // additive pattern database heuristic, see make_pattern_db()
+{
+	int tiles[PDB_PATTERNS][PDB_MAX_TILES]; // the tiles of each pattern
+	int sizes[PDB_PATTERNS];   // number of tiles in each pattern
+	uint8_t* tables[PDB_PATTERNS]; // tables[p][positions of the tiles, 4 bits each] is the moves needed by pattern p
+	MPI_Win win;               // node-shared window holding the tables
+} PatternDB;
+
+typedef struct DistClosed      // closed set spread over the procs in an MPI window, see closed_claim()
+{
+	MPI_Win win;               // every proc's segment, locked for the whole search (passive target)
+	uint64_t* slots;           // this proc's segment: pairs of (state, CLOSED_DEPTH - g), state 0 for an empty slot
+	size_t entries;            // pairs in each proc's segment, a power of 2
+	int nprocs;
+	long skipped;              // nodes not explored because another proc had explored them with a g at least as low
+} DistClosed;
+
+typedef struct Stealer         // work stealing state of one proc in a_star_search()
+{
+	int waiting;               // 1 while a request for work has not been answered
+	int replies_sent;          // number of replies with at least one node sent
+	int replies_received;      // number of replies with at least one node received
+	int* requests_sent;        // requests_sent[r] is the number of requests sent to proc r
+	int requests_received;     // number of requests received
+	unsigned int seed;         // state of the random number generator picking victims
+	int pending;               // number of replies whose send may not be done
+	int pending_capacity;      // size of the sends and buffers arrays
+	MPI_Request* sends;        // the pending sends
+	void** buffers;            // the nodes of each pending send, freed once it is done
+} Stealer;
+
+typedef struct CheckpointHeader // start of each segment of a checkpoint file written by checkpoint_save()
+{
+	uint64_t magic;            // CHECKPOINT_MAGIC
+	uint64_t start_state;      // the search the checkpoint belongs to
+	uint64_t goal_state;
+	int64_t iters;             // iterations done, the same on every proc
+	int64_t explored;          // nodes explored by the proc
+	uint64_t nodes;            // number of PackedNodes after the header, in this segment
+	int32_t nprocs;            // number of procs that wrote checkpoint files
+	int32_t rank;              // the proc that wrote this file
+	int32_t split;             // 1 if the open list had been divided between the procs
+	int32_t found_cost;        // best goal in the proc's table, INT_MAX if none
+	int32_t incumbent;         // best solution known to any proc, INT_MAX if none
+	int32_t shed_f;            // lowest f of the open nodes the proc shed (shed_open_nodes()), INT_MAX if none
+	int64_t generation;        // number of the segment, one more than the segment before it
+} CheckpointHeader;
+
+#define CHECKPOINT_RECORDS ((sizeof(CheckpointHeader) + sizeof(PackedNode) - 1) / sizeof(PackedNode)) // header size in PackedNodes
+
+typedef struct CheckpointManifest // the file naming the current set of checkpoint files, see checkpoint_start_set()
+{
+	uint64_t magic;            // MANIFEST_MAGIC
+	uint64_t start_state;      // the search the set belongs to
+	uint64_t goal_state;
+	int64_t base;              // generation of the first segment of each file, part of the file names
+	int32_t nprocs;            // number of files in the set
+	int32_t padding;
+} CheckpointManifest;
+
+typedef struct Checkpointer    // the checkpoint file one proc of a_star_search() appends to, see checkpoint_save()
+{
+	DiskStream* stream;        // this proc's file, NULL until the first checkpoint of the run
+	int64_t base;              // generation of the first segment of the run's set of files
+	int64_t generation;        // generation of the last segment written
+	int64_t old_base;          // the set the run's set replaces, deleted once the manifest names the new one
+	int old_nprocs;            // number of files in the old set, 0 for none
+	ChangeLog changes;         // nodes to write in the next segment
+	int failed;                // 1 once a file could not be written, no more checkpoints are written
+} Checkpointer;
+
+typedef struct ServeRequest    // a board sent to serve() by a client, waiting to be solved
+{
+	int client;                // index of the client's socket in serve()'s poll list
+	uint64_t state;            // the start board
+	double arrival;            // MPI_Wtime() when the request was read
+} ServeRequest;
+
+typedef struct ServeResult     // answer to one ServeRequest, sent from the proc that solved it to proc 0
+{
+	int steps;                 // number of moves, -1 if no solution was found within options.serve_limit nodes
+	int worker;                // proc that solved it
+	int request;               // index of the request in its batch
+	long explored;             // nodes explored
+	double seconds;            // time spent solving
+	uint8_t moves[MAX_PATH];   // the moves of the 0 tile, start first
+} ServeResult;
+
+typedef struct RaceStrategy    // one of the searches raced by portfolio_search()
+{
+	char* name;
+	int ida;                   // 1 for IDA*, 0 for a best-first search ordered by node_key()
+	double weight;             // weight of the best-first search (0 orders by h only), see scale_weight()
+	int reversed;              // 1 to generate children in the reverse move order, which changes how ties are broken
+} RaceStrategy;
+
+typedef struct Race            // cancellation state of one proc in portfolio_search()
+{
+	int cancelled;             // 1 once another proc has finished first
+	int sent;                  // 1 if this proc sent the cancel messages
+	long polls;                // calls to race_cancelled() so far
+	MPI_Request* requests;     // the cancel messages sent to the other procs
+} Race;
+
+typedef struct FsmString      // a move sequence considered by init_move_fsm()
+{
+	uint8_t moves[FSM_DEPTH];  // the moves of the 0 tile
+	int length;                // number of moves
+	uint64_t hash;             // hash of the board the moves lead to
+} FsmString;
+
+typedef struct TableEntry      // one slot of the IDA* transposition table
+{
+	uint64_t state;            // the state, 0 for an empty slot
+	uint16_t g;                // lowest number of moves the state was reached with in the current iteration
+	uint16_t bound;            // f bound of the iteration the entry was stored in, entries of older ones are ignored
+} TableEntry;
+
+typedef struct IdaSearch       // one IDA* search, shared by the calls of ida_search()
+{
+	int bound;                 // f bound of the current iteration
+	int next_bound;            // lowest f above the bound seen so far, the next iteration's bound
+	uint64_t goal_state;
+	Race* race;                // cancelled by the other procs in portfolio_search(), NULL for none
+	ServeResult* result;       // the moves of the current path, and the counters
+	TableEntry* tt;            // transposition table, NULL for none
+	size_t tt_mask;            // number of table entries - 1
+	long tt_pruned;            // nodes skipped because the table had them with a g at least as low
+} IdaSearch;
+
+typedef struct Lookahead       // the lookahead probes (AL*) of one a_star_search(), shared by the calls of lookahead_probe()
+{
+	NodeTable* table;
+	BucketQueue* open_list;
+	Histogram* f_hist;
+	Incumbent* incumbent;
+	DistClosed* closed;        // distributed closed set once the open list is split, NULL for none
+	uint64_t goal_state;
+	int weight;
+	int bound;                 // key of the node whose expansion started the probe
+	int* found_cost;           // lowest cost of a solution found by this proc
+	long* explored;            // nodes explored by this proc, probes included
+	long probed;               // nodes the probes explored without going through the open list
+} Lookahead;
+
+typedef struct Lane            // the IDA* search of one board in one lane of lockstep_ida()
+{
+	int board;                 // index of the board in the batch, -1 once the lane has no board left
+	int depth;                 // moves on the current path
+	int bound;                 // f bound of the current iteration
+	int next_bound;            // lowest f above the bound seen in this iteration, the next iteration's bound
+	uint64_t states[MAX_PATH + 1]; // the states on the current path, start first
+	uint8_t hs[MAX_PATH + 1];  // their Manhattan Distance
+	uint8_t blanks[MAX_PATH + 1]; // index of their 0 tile
+	uint8_t next[MAX_PATH + 1];   // next move to try from each of them
+	int16_t fsm[MAX_PATH + 1]; // FSM node the moves to each of them lead to (see init_move_fsm())
+} Lane;
+
+typedef struct CacheEntry      // cached cost to the goal of one state, 16 bytes
+{
+	uint64_t state;            // the state, 0 for an empty entry
+	uint32_t last_used;        // value of the cache's clock when the entry was last stored or used
+	uint16_t cost;             // moves from the state to the goal on the cached path
+	uint8_t move;              // first move of the 0 tile on the cached path
+	uint8_t exact;             // 1 if the path is optimal, so cost is the exact distance
+} CacheEntry;
+
+typedef struct CacheHeader     // start of a result cache file, followed by the entries
 {
-	int board[ROWS][COLS];     // the 2d array representing the n-puzzle 
-	int h_score;               // the heuristic value given to the board
-	struct Board* parent;      // pointer to parent board if one exists (used to track sequence of moves taken)
-} Board;
+	uint64_t magic;            // CACHE_MAGIC
+	uint32_t sets;             // number of sets of CACHE_WAYS entries, a power of 2
+	uint32_t clock;            // counts stores and hits, for least recently used eviction
+	uint64_t goal_state;       // the goal the cached paths lead to
+} CacheHeader;
+
+typedef struct ResultCache     // solved states kept by serve() in a memory mapped file between runs
+{
+	CacheHeader* header;       // the mapped file
+	CacheEntry* entries;       // sets * CACHE_WAYS entries, right after the header
+	size_t bytes;              // size of the mapping
+	uint32_t sets;             // number of sets
+	int writable;              // 1 on proc 0, which updates the cache; other procs only read it
+} ResultCache;
+
+PatternDB* pdb = NULL;         // the pattern database, NULL unless --pdb is given
+int shed_f = INT_MAX;          // lowest f of the open nodes a_star_search() dropped for lack of memory, see shed_open_nodes()
+
+RaceStrategy race_strategies[] = {      // proc r of portfolio_search() runs race_strategies[r % RACE_STRATEGIES]
+	{ "greedy best-first (h)", 0, 0, 0 },
+	{ "weighted A* (w = 2)", 0, 2, 0 },
+	{ "IDA*", 1, 1, 0 },
+	{ "greedy best-first (h), reversed moves", 0, 0, 1 },
+	{ "weighted A* (w = 1.5), reversed moves", 0, 1.5, 1 },
+	{ "weighted A* (w = 3)", 0, 3, 0 },
+	{ "A*", 0, 1, 0 },
+	{ "weighted A* (w = 1.2), reversed moves", 0, 1.2, 1 },
+};
+
+#define RACE_STRATEGIES ((int)(sizeof(race_strategies) / sizeof(RaceStrategy)))
+
+int transpose_move[4] = { MOVE_LEFT, MOVE_RIGHT, MOVE_UP, MOVE_DOWN }; // each move mirrored over the main diagonal
+int fsm_next[FSM_MAX_NODES][4]; // fsm_next[node][move] is the FSM node after the 0 tile makes 'move', -1 if the sequence is pruned
+int fsm_nodes = 0;             // number of FSM nodes, node 0 is the start
+
+
+/* Makes the moves of 's' from the middle of an open FSM_GRID x FSM_GRID
+ * board whose squares hold their own index (the 0 tile starts on the
+ * middle square), so two sequences with the same effect on any board give
+ * the same 'grid' */
+void fsm_grid(FsmString* s, uint8_t grid[FSM_GRID * FSM_GRID]){
+	int deltas[4] = { -FSM_GRID, FSM_GRID, -1, 1 };
+	int blank = FSM_GRID * FSM_GRID / 2;
+	for(int i = 0; i < FSM_GRID * FSM_GRID; i++) grid[i] = i;
+	for(int i = 0; i < s->length; i++){
+		int next = blank + deltas[s->moves[i]];
+		uint8_t tile = grid[next];
+		grid[next] = grid[blank];
+		grid[blank] = tile;
+		blank = next;
+	}
+}
+
+/* Returns 1 if 'length' moves lead to a node of the trie marked pruned */
+int fsm_pruned(int trie[FSM_MAX_NODES][4], int* pruned, uint8_t* moves, int length){
+	int node = 0;
+	for(int i = 0; i < length && node >= 0; i++) node = trie[node][moves[i]];
+	return node >= 0 && pruned[node];
+}
+
+/* Builds fsm_next, a finite-state machine over the moves of the 0 tile
+ * that prunes move sequences with a duplicate (Taylor and Korf).  Every
+ * sequence of up to FSM_DEPTH moves is made on an open board, in order of
+ * length and then of move number, which is the order ida_search() tries
+ * them in.  A sequence that ends on the same board as an earlier one is a
+ * duplicate and is pruned (moving back and forth, or going half way
+ * around a 2x2 block one way instead of the other), and sequences
+ * containing a pruned one are not extended.  On the 4x4 board the earlier
+ * sequence is possible wherever the pruned one is, so no board becomes
+ * unreachable and IDA* stays optimal.  The pruned sequences are put in a
+ * trie turned into the FSM with Aho-Corasick failure links, so each move
+ * costs one table lookup.  With --no-fsm only sequences of 2 moves are
+ * compared, so the FSM just prunes moving the 0 tile straight back */
+void init_move_fsm(){
+	static int trie[FSM_MAX_NODES][4];   // children of each trie node, -1 for none
+	int pruned[FSM_MAX_NODES] = { 0 };   // 1 if the node ends a pruned sequence, or one of its suffixes does
+	int fail[FSM_MAX_NODES];             // node of the longest proper suffix that is also in the trie
+	int queue[FSM_MAX_NODES];
+	int capacity = 1;
+	for(int d = 1; d <= FSM_DEPTH; d++) capacity = capacity * 4 + 1;
+	FsmString* kept = malloc(capacity * sizeof(FsmString)); // the sequences that are not pruned, in order
+	assert(kept);
+	uint8_t grid[FSM_GRID * FSM_GRID];
+	uint8_t other[FSM_GRID * FSM_GRID];
+	memset(trie, -1, sizeof(trie));
+	fsm_nodes = 1;
+
+	int count = 1;                       // kept[0] is the empty sequence
+	kept[0].length = 0;
+	fsm_grid(&kept[0], grid);
+	kept[0].hash = 0;
+	for(int i = 0; i < FSM_GRID * FSM_GRID; i++) kept[0].hash = kept[0].hash * 31 + grid[i];
+	int level_start = 0;
+	int depth = options.fsm ? FSM_DEPTH : 2; // --no-fsm only prunes moving back
+	for(int d = 1; d <= depth; d++){
+		int level_end = count;
+		for(int p = level_start; p < level_end; p++){
+			for(int move = 0; move < 4; move++){
+				FsmString s = kept[p];
+				s.moves[s.length++] = move;
+				int skip = 0;
+				for(int k = 1; k < d - 1 && !skip; k++) skip = fsm_pruned(trie, pruned, s.moves + k, d - k);
+				if(skip) continue;           // has a pruned sequence at its end
+				fsm_grid(&s, grid);
+				s.hash = 0;
+				for(int i = 0; i < FSM_GRID * FSM_GRID; i++) s.hash = s.hash * 31 + grid[i];
+				int duplicate = 0;
+				for(int i = 0; i < count && !duplicate; i++){
+					if(kept[i].hash != s.hash) continue;
+					fsm_grid(&kept[i], other);
+					duplicate = memcmp(grid, other, sizeof(grid)) == 0;
+				}
+				if(!duplicate){
+					kept[count++] = s;
+					continue;
+				}
+				int node = 0;                // add the pruned sequence to the trie
+				for(int i = 0; i < s.length; i++){
+					if(trie[node][s.moves[i]] < 0){
+						assert(fsm_nodes < FSM_MAX_NODES);
+						trie[node][s.moves[i]] = fsm_nodes++;
+					}
+					node = trie[node][s.moves[i]];
+				}
+				pruned[node] = 1;
+			}
+		}
+		level_start = level_end;
+	}
+	free(kept);
+
+	int head = 0, tail = 0;              // breadth-first over the trie, so a node's failure link is done first
+	fail[0] = 0;
+	for(int move = 0; move < 4; move++){
+		int child = trie[0][move];
+		fsm_next[0][move] = child >= 0 ? child : 0;
+		if(child >= 0){
+			fail[child] = 0;
+			queue[tail++] = child;
+		}
+	}
+	while(head < tail){
+		int node = queue[head++];
+		pruned[node] |= pruned[fail[node]];
+		for(int move = 0; move < 4; move++){
+			int child = trie[node][move];
+			if(child >= 0){
+				fail[child] = fsm_next[fail[node]][move];
+				fsm_next[node][move] = child;
+				queue[tail++] = child;
+			} else {
+				fsm_next[node][move] = fsm_next[fail[node]][move];
+			}
+		}
+	}
+	for(int node = 0; node < fsm_nodes; node++){
+		for(int move = 0; move < 4; move++){
+			if(pruned[fsm_next[node][move]]) fsm_next[node][move] = -1;
+		}
+	}
+}
+
+/* Returns the MPI_Comm_split_type() type grouping the procs that share one
+ * copy in allocate_node_shared(): the procs on the same NUMA domain (socket)
+ * with --numa when the MPI library can tell (Open MPI), else the procs on
+ * the same node */
+int shared_split_type(){
+#ifdef OPEN_MPI
+	if(options.numa) return OMPI_COMM_TYPE_NUMA;
+#endif
+	return MPI_COMM_TYPE_SHARED;
+}
+
+/* Allocates 'bytes' of memory shared by all procs on the same node in an
+ * MPI-3 shared window (collective).  Only the node leader (the proc with
+ * rank 0 on the node) gets real memory, the other procs map the leader's
+ * copy, so the node holds a single copy however many procs it runs.
+ * With --numa the "node" is a NUMA domain, so each socket has its own copy,
+ * placed in the socket's memory by the leader touching it first.
+ * 'leader' is set to 1 on the node leader and 0 on every other proc */
+void* allocate_node_shared(size_t bytes, MPI_Win* win, int* leader){
+	MPI_Comm node_comm;
+	int node_rank;
+	void* base;
+	MPI_Comm_split_type(MPI_COMM_WORLD, shared_split_type(), rank, MPI_INFO_NULL, &node_comm);
+	MPI_Comm_rank(node_comm, &node_rank);
+	*leader = node_rank == 0;
+	MPI_Win_allocate_shared(*leader ? bytes : 0, 1, MPI_INFO_NULL, node_comm, &base, win);
+	if(!*leader){
+		MPI_Aint size;
+		int disp_unit;
+		MPI_Win_shared_query(*win, 0, &size, &disp_unit, &base); // address of the leader's copy
+	}
+	MPI_Comm_free(&node_comm);
+	return base;
+}
+
+/* Returns the index into a pattern's table of the positions of its tiles,
+ * 4 bits per tile.  'positions' holds the index of every tile on the board */
+uint32_t pattern_index(PatternDB* db, int pattern, int positions[TILES]){
+	uint32_t index = 0;
+	for(int i = 0; i < db->sizes[pattern]; i++){
+		index |= (uint32_t)positions[db->tiles[pattern][i]] << (4 * i);
+	}
+	return index;
+}
+
+/* Fills the table of one pattern with a breadth-first search backward from
+ * the goal positions of its tiles.  A pattern tile may move to any adjacent
+ * square not taken by another tile of the pattern, and only moves of pattern
+ * tiles are counted.  Every real move moves one tile of one pattern by one
+ * square, so the sum over disjoint patterns is admissible and consistent */
+void build_pattern(PatternDB* db, int pattern){
+	int size = db->sizes[pattern];
+	uint32_t entries = 1u << (4 * size);
+	uint8_t* table = db->tables[pattern];
+	uint32_t* queue = malloc(entries * sizeof(uint32_t)); // far more than the reachable entries
+	assert(queue);
+	memset(table, 0xFF, entries);            // 0xFF marks entries not reached yet, first touch by the building thread
+
+	uint32_t goal = 0;
+	for(int i = 0; i < size; i++){
+		goal |= (uint32_t)goal_index[db->tiles[pattern][i]] << (4 * i);
+	}
+	table[goal] = 0;
+	size_t head = 0, tail = 0;
+	queue[tail++] = goal;
+	while(head < tail){
+		uint32_t index = queue[head++];
+		int occupied = 0;                    // bit i is set if a pattern tile is on board index i
+		for(int i = 0; i < size; i++){
+			occupied |= 1 << ((index >> (4 * i)) & 0xF);
+		}
+		for(int i = 0; i < size; i++){
+			int pos = (index >> (4 * i)) & 0xF;
+			for(int move = 0; move < 4; move++){
+				if(!move_possible(pos, move)) continue;
+				int target = pos + move_delta[move];
+				if(occupied & (1 << target)) continue;
+				uint32_t next = (index & ~(0xFu << (4 * i))) | ((uint32_t)target << (4 * i));
+				if(table[next] == 0xFF){
+					table[next] = table[index] + 1;
+					queue[tail++] = next;
+				}
+			}
+		}
+	}
+	free(queue);
+}
+
+/* Sets up the additive 6-6-3 pattern database used as the heuristic when
+ * --pdb is given (collective).  Each pattern is the tiles whose goal
+ * squares form one block of the board (table_goal, see
+ * init_packed_tables()).  The tables (about 32 MB) are placed in a
+ * node-shared window (one per socket with --numa), so the node leader fills them once, either from
+ * options.pdb_file when it holds the tables of the same goal or by building
+ * them (then saving them to options.pdb_file if one is given), and every
+ * other proc on the node reads the leader's copy.  Returns the PatternDB,
+ * which is never NULL */
+PatternDB* make_pattern_db(){
+	static const int blocks[PDB_PATTERNS][PDB_MAX_TILES] = {
+		{ 1, 2, 3, 5, 6, 7 },                // top right 2x3 block
+		{ 4, 8, 9, 12, 13, 14 },             // bottom left block
+		{ 10, 11, 15 }                       // bottom right block
+	};
+	static const int sizes[PDB_PATTERNS] = { 6, 6, 3 };
+	PatternDB* db = malloc(sizeof(PatternDB));
+	assert(db);
+	size_t bytes = 0;
+	for(int p = 0; p < PDB_PATTERNS; p++){
+		db->sizes[p] = sizes[p];
+		for(int i = 0; i < sizes[p]; i++){
+			int tile = packed_tile(table_goal, blocks[p][i]);
+			db->tiles[p][i] = tile != 0 ? tile : packed_tile(table_goal, 0); // the goal's 0 tile is on this square, so square 0's tile takes its place
+		}
+		bytes += (size_t)1 << (4 * sizes[p]);
+	}
+	int leader;
+	uint8_t* base = allocate_node_shared(bytes, &db->win, &leader);
+	size_t offset = 0;
+	for(int p = 0; p < PDB_PATTERNS; p++){
+		db->tables[p] = base + offset;
+		offset += (size_t)1 << (4 * sizes[p]);
+	}
+
+	MPI_Win_fence(0, db->win);
+	if(leader){
+		FILE* file = options.pdb_file != NULL ? fopen(options.pdb_file, "rb") : NULL;
+		uint64_t goal = 0;                   // the goal the file's tables were built for, stored after them
+		if(file != NULL && fread(base, 1, bytes, file) == bytes && fread(&goal, sizeof(goal), 1, file) == 1 && goal == table_goal){
+			fclose(file);
+		} else {
+			if(file != NULL) fclose(file);
+			#pragma omp parallel for schedule(dynamic, 1)
+			for(int p = 0; p < PDB_PATTERNS; p++){ // with OpenMP, the patterns are built by different threads
+				build_pattern(db, p);
+			}
+			if(options.pdb_file != NULL && (file = fopen(options.pdb_file, "wb")) != NULL){
+				fwrite(base, 1, bytes, file);
+				fwrite(&table_goal, sizeof(table_goal), 1, file);
+				fclose(file);
+			}
+		}
+	}
+	MPI_Win_fence(0, db->win);               // the leader's tables are visible to the node from here on
+	return db;
+}
+
+/* Frees the shared window of the pattern database (collective) */
+void destroy_pattern_db(PatternDB* db){
+	MPI_Win_free(&db->win);
+	free(db);
+}
+
+/* Returns the pattern database heuristic of a packed state: the sum of
+ * each pattern's table entry for the positions of its tiles */
+int pdb_heuristic(PatternDB* db, uint64_t state){
+	int positions[TILES];
+	for(int index = 0; index < TILES; index++){
+		positions[packed_tile(state, index)] = index;
+	}
+	int sum = 0;
+	for(int p = 0; p < PDB_PATTERNS; p++){
+		sum += db->tables[p][pattern_index(db, p, positions)];
+	}
+	return sum;
+}
+
+/* Heuristic value of a packed state used by a_star_search() and
+ * ara_star_search(): the pattern database when --pdb is given, the
+ * Manhattan Distance otherwise */
+int heuristic(uint64_t state){
+	if(pdb != NULL) return pdb_heuristic(pdb, state);
+	return packed_manhattan(state);
+}
+
+/* Heuristic value of 'child', the state after the 0 tile at index 'blank'
+ * of 'state' (whose heuristic value is h) is moved in the given direction.
+ * The Manhattan Distance is updated from the one tile that moved */
+int child_heuristic(uint64_t state, int h, int blank, int move, uint64_t child){
+	if(pdb != NULL) return pdb_heuristic(pdb, child);
+	return h + packed_manhattan_delta(state, blank, move);
+}
+
+/* Sets a Histogram to count no nodes */
+void init_histogram(Histogram* hist){
+	memset(hist->count, 0, sizeof(hist->count));
+	hist->min = HIST_VALUES;
+}
+
+/* Counts one more open node with the given value */
+void histogram_add(Histogram* hist, int value){
+	if(value >= HIST_VALUES) value = HIST_VALUES - 1;
+	hist->count[value]++;
+	if(value < hist->min) hist->min = value;
+}
+
+/* Counts one less open node with the given value */
+void histogram_remove(Histogram* hist, int value){
+	if(value >= HIST_VALUES) value = HIST_VALUES - 1;
+	hist->count[value]--;
+	while(hist->min < HIST_VALUES && hist->count[hist->min] == 0){
+		hist->min++;
+	}
+}
+
+/* Divides the open nodes between the procs once the open list is big enough
+ * for each proc to have at least 2 nodes.  Every proc has made the same moves
+ * up to this point, so they all see the same nodes in the same order and each
+ * keeps every nprocs-th one, starting at its rank, which gives each proc some
+ * of the best nodes.  The nodes given to other procs are marked closed (and
+ * given) in this proc's table so it does not explore them unless it finds a
+ * cheaper path */
+void split_open_list(BucketQueue* open_list, NodeTable* table, Histogram* f_hist, int rank, int nprocs){
+	size_t count = 0;                        // number of valid open nodes seen so far
+	for(int p = 0; p < open_list->priorities; p++){
+		OpenList* bucket = open_list->buckets[p];
+		if(bucket == NULL) continue;
+		size_t kept = 0;
+		for(size_t i = 0; i < bucket->size; i++){
+			PackedNode node = bucket->nodes[i];
+			PackedNode* entry = table_find(table, node.state);
+			int valid = entry != NULL && !(entry->move & MOVE_CLOSED) && entry->g == node.g;
+			if(valid && count++ % nprocs == (size_t)rank){
+				bucket->nodes[kept++] = node;
+			} else {
+				if(valid){               // owned by another proc
+					entry->move |= MOVE_CLOSED;
+					entry->given = 1;
+					note_change(entry->state);
+				}
+				histogram_remove(f_hist, node.g + node.h);
+				open_list->size--;
+			}
+		}
+		bucket->size = kept;
+	}
+	open_list->min = 0;
+}
+
+/* Returns the priority node_key() gives a node with the given g and h */
+int key_of(int g, int h, int weight){
+	if(weight == 0) return h;
+	return g * WEIGHT_SCALE + weight * h;
+}
+
+/* Returns the priority of a node in a_star_search() and ara_star_search().
+ * With a weight of 0 it is just h (greedy best-first search, the original
+ * ordering).  Otherwise it is g + w*h with both terms multiplied by
+ * WEIGHT_SCALE, where 'weight' is w*WEIGHT_SCALE rounded to an int */
+int node_key(PackedNode* node, int weight){
+	return key_of(node->g, node->h, weight);
+}
+
+/* Number of priorities a BucketQueue ordered by node_key() needs */
+int key_priorities(int weight){
+	if(weight == 0) return DISK_MAX_H;
+	return MAX_PATH * WEIGHT_SCALE + weight * DISK_MAX_H;
+}
+
+/* Converts a weight given on the command line to the int used by node_key() */
+int scale_weight(double weight){
+	return (int)(weight * WEIGHT_SCALE + 0.5);
+}
+
+/* Prints a sequence of packed states like print_parents().  path[0] is the
+ * goal and path[steps-1] is the board one move after the start board */
+void print_state_sequence(uint64_t* path, int steps){
+	Board* brd = make_empty_board();
+	printf("\n----- SOLUTION SEQUENCE -----\n");
+	for(int i = 0; i < steps; i++){
+		unpack_board(path[i], brd);
+		brd->h_score = packed_manhattan(path[i]);
+		printf("\n");
+		print_board(brd);
+	}
+	destroy_board(brd);
+	printf("\n----- SOLUTION SEQUENCE -----\n");
+	printf("\n----------------------------------\n");
+	printf("\nNumber of moves to solution: %d\n", steps);
+	printf("\n----------------------------------\n\n");
+}
+
+/* Prints the solution found by one of the searches: the sequence of
+ * moves, the initial and final boards, and the number of explored states */
+void print_solution(Board* start, Board* goal, long iters, long explored, uint64_t* path, int steps){
+	printf("\n----------SOLUTION FOUND----------\n");
+	printf("\nITERATIONS: %ld\n", iters);
+	print_state_sequence(path, steps);
+	printf("INITIAL BOARD:\n");
+	print_board(start);
+	printf("\nFINAL BOARD:\n");
+	print_board(goal);
+	printf("\n---------------------------\n");
+	printf("EXPLORED %ld STATES\n", explored);
+	printf("---------------------------\n");
+	printf("\n----------SOLUTION FOUND-----------\n");
+}
+
+/* Follows a node and all of its parents back to the start board and stores
+ * their states in a newly allocated array (goal first).  Each parent is found
+ * by undoing the node's generating move and looking the resulting state up in
+ * the table.  Returns the number of moves, which is the length of the array */
+int trace_packed_path(NodeTable* table, PackedNode* node, uint64_t** path){
+	int steps = node->g;
+	*path = malloc((steps + 1) * sizeof(uint64_t));
+	assert(*path);
+	steps = 0;
+	while(!(node->move & MOVE_ROOT)){
+		(*path)[steps++] = node->state;
+		int move = node->move & MOVE_MASK;
+		int blank = node_blank(node);
+		node = table_find(table, packed_move(node->state, blank, move ^ 1)); // step back to the parent
+		assert(node);
+	}
+	return steps;
+}
+
+/* Allocates an Incumbent with no solution for the given number of procs */
+Incumbent* make_incumbent(int nprocs){
+	Incumbent* inc = malloc(sizeof(Incumbent));
+	assert(inc);
+	inc->cost = INT_MAX;
+	inc->values = calloc(nprocs, sizeof(int));
+	inc->sent = calloc(nprocs, sizeof(int));
+	inc->requests = malloc(nprocs * sizeof(MPI_Request));
+	inc->owed = calloc(nprocs, sizeof(int));
+	assert(inc->values && inc->sent && inc->requests && inc->owed);
+	for(int r = 0; r < nprocs; r++){
+		inc->requests[r] = MPI_REQUEST_NULL;
+	}
+	inc->nprocs = nprocs;
+	inc->received = 0;
+	return inc;
+}
+
+/* Sends the incumbent to every proc it is owed to whose last send has
+ * completed.  A send is never waited on here: the other proc may be busy
+ * in a collective and only post its receive later */
+void incumbent_send(Incumbent* inc){
+	for(int r = 0; r < inc->nprocs; r++){
+		if(!inc->owed[r]) continue;
+		int done;
+		MPI_Test(&inc->requests[r], &done, MPI_STATUS_IGNORE);
+		if(!done) continue;                  // tried again at the next incumbent_poll()
+		inc->values[r] = inc->cost;
+		MPI_Isend(&inc->values[r], 1, MPI_INT, r, TAG_INCUMBENT, MPI_COMM_WORLD, &inc->requests[r]);
+		inc->sent[r]++;
+		inc->owed[r] = 0;
+	}
+}
+
+/* Records a solution of the given cost found by this proc.  If it is better
+ * than the incumbent, the new cost is sent to every other proc without
+ * waiting for them to receive it */
+void incumbent_publish(Incumbent* inc, int cost, int rank, int nprocs){
+	if(cost >= inc->cost) return;
+	inc->cost = cost;
+	for(int r = 0; r < nprocs; r++){
+		if(r != rank) inc->owed[r] = 1;
+	}
+	incumbent_send(inc);
+}
+
+/* Receives every cost other procs have sent so far and keeps the lowest,
+ * and sends the costs still owed to other procs */
+void incumbent_poll(Incumbent* inc){
+	incumbent_send(inc);
+	int flag = 1;
+	while(flag){
+		MPI_Status status;
+		MPI_Iprobe(MPI_ANY_SOURCE, TAG_INCUMBENT, MPI_COMM_WORLD, &flag, &status);
+		if(flag){
+			int cost;
+			MPI_Recv(&cost, 1, MPI_INT, status.MPI_SOURCE, TAG_INCUMBENT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			inc->received++;
+			if(cost < inc->cost) inc->cost = cost;
+		}
+	}
+}
+
+/* Receives every cost still on its way and completes all sends, so no
+ * messages are left over when the search ends (collective), then frees the
+ * Incumbent.  The receives are posted before the sends are waited on: a
+ * send may only complete once its receive is posted.  Costs still owed are
+ * dropped, the final result is agreed on by the search itself */
+void incumbent_finish(Incumbent* inc, int rank, int nprocs){
+	int* totals = malloc(nprocs * sizeof(int));
+	assert(totals);
+	MPI_Allreduce(inc->sent, totals, nprocs, MPI_INT, MPI_SUM, MPI_COMM_WORLD); // totals[r] is the number sent to r
+	while(inc->received < totals[rank]){
+		int cost;
+		MPI_Recv(&cost, 1, MPI_INT, MPI_ANY_SOURCE, TAG_INCUMBENT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		inc->received++;
+	}
+	MPI_Waitall(nprocs, inc->requests, MPI_STATUSES_IGNORE); // every proc has received all its costs
+	free(totals);
+	free(inc->values);
+	free(inc->sent);
+	free(inc->requests);
+	free(inc->owed);
+	free(inc);
+}
+
+/* Follows the chain of parents from the given state through this proc's
+ * table, collecting the generating moves, until it reaches the start board
+ * or a node whose parent is in another proc's table.  The moves are sent to
+ * proc 0 as segment 'index' of the path (or stored in 'segments' on proc 0),
+ * and if the chain continues on another proc, the parent's state is sent to
+ * that proc so it can trace the next segment */
+void trace_segment(NodeTable* table, uint64_t state, int index, uint8_t** segments, int* lengths, int rank){
+	PackedNode* node = table_find(table, state);
+	assert(node);
+	uint8_t* message = malloc(node->g + 3); // {index (2 bytes), last segment flag, moves...}, a parent's g is lower than its child's
+	assert(message);
+	int count = 0;
+	int next_rank = rank;
+	while(!(node->move & MOVE_ROOT) && next_rank == rank){
+		int move = node->move & MOVE_MASK;
+		message[3 + count++] = move;
+		state = packed_move(node->state, node_blank(node), move ^ 1); // the parent's state
+		next_rank = node->parent_rank;
+		if(next_rank == rank){
+			node = table_find(table, state);
+			assert(node);
+		}
+	}
+	int last = next_rank == rank;           // reached the start board
+	message[0] = index & 0xFF;
+	message[1] = index >> 8;
+	message[2] = last;
+	if(rank == 0){
+		segments[index] = message;
+		lengths[index] = count;
+	} else {
+		MPI_Send(message, count + 3, MPI_BYTE, 0, TAG_SEGMENT, MPI_COMM_WORLD);
+		free(message);
+	}
+	if(!last){
+		uint64_t token[2] = { state, index + 1 };
+		MPI_Send(token, 2, MPI_UINT64_T, next_rank, TAG_TRACE, MPI_COMM_WORLD);
+	}
+}
+
+/* Rebuilds the solution sequence when the chain of parents from the goal
+ * may run through the tables of several procs (collective).  Each node keeps
+ * its generating move and the rank of the proc that holds its parent, so the
+ * procs pass a token holding the state to continue from, starting on the
+ * 'winner' proc that holds the goal, and each one sends the moves of its part
+ * of the chain to proc 0.  Only the moves of the path cross the network.
+ * On proc 0 the states of the path (goal first) are stored in a newly
+ * allocated array and the number of moves is returned, other procs return -1 */
+int trace_distributed_path(NodeTable* table, uint64_t goal_state, int winner, int rank, int nprocs, uint64_t** path){
+	uint8_t** segments = NULL;              // on proc 0, the moves of each segment received so far
+	int* lengths = NULL;
+	if(rank == 0){
+		segments = calloc(MAX_SEGMENTS, sizeof(uint8_t*));
+		lengths = calloc(MAX_SEGMENTS, sizeof(int));
+		assert(segments && lengths);
+	}
+	int total = -1;                          // on proc 0, number of segments, known once the last one arrives
+	if(rank == winner){
+		trace_segment(table, goal_state, 0, segments, lengths, rank);
+		if(rank == 0 && segments[0][2]) total = 1;
+	}
+
+	if(rank != 0){                           // trace segments until proc 0 has the whole path
+		while(1){
+			uint64_t token[2];
+			MPI_Status status;
+			MPI_Recv(token, 2, MPI_UINT64_T, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+			if(status.MPI_TAG == TAG_DONE) break;
+			trace_segment(table, token[0], (int)token[1], segments, lengths, rank);
+		}
+		return -1;
+	}
+
+	while(1){
+		int complete = total != -1;
+		for(int i = 0; i < total && complete; i++){
+			if(segments[i] == NULL) complete = 0;
+		}
+		if(complete) break;
+		MPI_Status status;
+		MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+		if(status.MPI_TAG == TAG_TRACE){
+			uint64_t token[2];
+			MPI_Recv(token, 2, MPI_UINT64_T, status.MPI_SOURCE, TAG_TRACE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			int index = (int)token[1];
+			trace_segment(table, token[0], index, segments, lengths, rank);
+			if(segments[index][2]) total = index + 1; // the last segment gives the number of segments
+		} else {
+			int size;
+			MPI_Get_count(&status, MPI_BYTE, &size);
+			uint8_t* message = malloc(size);
+			assert(message);
+			MPI_Recv(message, size, MPI_BYTE, status.MPI_SOURCE, TAG_SEGMENT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			int index = message[0] | (message[1] << 8);
+			segments[index] = message;
+			lengths[index] = size - 3;
+			if(message[2]) total = index + 1;
+		}
+	}
+	for(int r = 1; r < nprocs; r++){         // let the other procs stop waiting for tokens
+		uint64_t done[2] = { 0, 0 };
+		MPI_Send(done, 2, MPI_UINT64_T, r, TAG_DONE, MPI_COMM_WORLD);
+	}
+
+	int steps = 0;
+	for(int i = 0; i < total; i++) steps += lengths[i];
+	*path = malloc((steps + 1) * sizeof(uint64_t));
+	assert(*path);
+	uint64_t state = goal_state;             // undo the moves from the goal back to the start
+	int index = 0;
+	for(int i = 0; i < total; i++){
+		for(int j = 0; j < lengths[i]; j++){
+			(*path)[index++] = state;
+			int move = segments[i][3 + j];
+			state = packed_move(state, packed_blank(state), move ^ 1);
+		}
+		free(segments[i]);
+	}
+	free(segments);
+	free(lengths);
+	return steps;
+}
+
+/* Runs in a DiskStream's I/O thread.  Writes the buffer given by
+ * io_buffer to the file, or for a reader fills it from the file.  A short
+ * write or a read error sets 'failed' for the search to check */
+void* disk_io(void* arg){
+	DiskStream* stream = arg;
+	int b = stream->io_buffer;
+	if(stream->writing){
+		size_t written = fwrite(stream->buffers[b], sizeof(PackedNode), stream->counts[b], stream->file);
+		if(written != stream->counts[b] || fflush(stream->file) != 0) stream->failed = 1;
+	} else {
+		stream->counts[b] = fread(stream->buffers[b], sizeof(PackedNode), stream->capacity, stream->file);
+		if(ferror(stream->file)) stream->failed = 1;
+	}
+	return NULL;
+}
+
+/* Starts reading or writing the given buffer in the background */
+void disk_start_io(DiskStream* stream, int b){
+	stream->io_buffer = b;
+	stream->busy = 1;
+	int err = pthread_create(&stream->thread, NULL, disk_io, stream);
+	assert(err == 0);
+}
+
+/* Waits for the background read or write (if any) to finish */
+void disk_wait(DiskStream* stream){
+	if(stream->busy){
+		pthread_join(stream->thread, NULL);
+		stream->busy = 0;
+	}
+}
+
+/* Opens a file of PackedNodes for sequential reading or writing (appending)
+ * with two buffers of the given number of nodes.  While the search works
+ * on one buffer the other is read or written by a background thread.
+ * Returns NULL if a file to be read does not exist or a file to be written
+ * cannot be opened */
+DiskStream* disk_open(char* path, int writing, size_t capacity){
+	FILE* file = fopen(path, writing ? "ab" : "rb");
+	if(file == NULL) return NULL;
+	DiskStream* stream = malloc(sizeof(DiskStream));
+	assert(stream);
+	stream->file = file;
+	stream->writing = writing;
+	stream->capacity = capacity;
+	for(int b = 0; b < 2; b++){
+		stream->buffers[b] = malloc(capacity * sizeof(PackedNode));
+		assert(stream->buffers[b]);
+		stream->counts[b] = 0;
+	}
+	stream->active = 0;
+	stream->pos = 0;
+	stream->busy = 0;
+	stream->failed = 0;
+	if(!writing){
+		disk_start_io(stream, 1); // the first get() swaps to this buffer
+	}
+	return stream;
+}
+
+/* Adds a node to the end of a file opened for writing.  When the active
+ * buffer is full it is handed to the I/O thread and the other one is used */
+void disk_put(DiskStream* stream, PackedNode node){
+	if(stream->counts[stream->active] == stream->capacity){
+		disk_wait(stream);
+		disk_start_io(stream, stream->active);
+		stream->active = !stream->active;
+		stream->counts[stream->active] = 0;
+	}
+	stream->buffers[stream->active][stream->counts[stream->active]++] = node;
+}
+
+/* Reads the next node of a file opened for reading into 'node'.  Returns 1
+ * on success and 0 at the end of the file or on a read error ('failed' is
+ * set).  When the active buffer is used
+ * up the prefetched one is swapped in and the next block is prefetched */
+int disk_get(DiskStream* stream, PackedNode* node){
+	while(stream->pos == stream->counts[stream->active]){
+		if(!stream->busy) return 0; // end of file was already reached
+		disk_wait(stream);
+		if(stream->counts[!stream->active] == 0) return 0;
+		stream->active = !stream->active;
+		stream->pos = 0;
+		disk_start_io(stream, !stream->active);
+	}
+	*node = stream->buffers[stream->active][stream->pos++];
+	return 1;
+}
+
+/* Hands a writer's partly filled buffer to the I/O thread, so the file
+ * holds every node put so far once the thread is done, and goes on with
+ * the other buffer.  With 'wait' it also waits for the write.  Returns 0
+ * on success and -1 if a write of the stream has failed */
+int disk_flush(DiskStream* stream, int wait){
+	disk_wait(stream);
+	if(stream->counts[stream->active] > 0){
+		disk_start_io(stream, stream->active);
+		stream->active = !stream->active;
+		stream->counts[stream->active] = 0;
+	}
+	if(wait) disk_wait(stream);
+	return stream->failed ? -1 : 0;
+}
+
+/* Flushes a writer, closes the file, and frees the DiskStream.  Returns 0
+ * on success and -1 if any read or write of the stream failed */
+int disk_close(DiskStream* stream){
+	if(stream->writing) disk_flush(stream, 1);
+	disk_wait(stream);
+	if(fclose(stream->file) != 0) stream->failed = 1;
+	int failed = stream->failed;
+	free(stream->buffers[0]);
+	free(stream->buffers[1]);
+	free(stream);
+	return failed ? -1 : 0;
+}
+
+/* Adds a node to the open list of a_star_search() unless its state was
+ * already reached with a g at least as low.  A state reached again with a
+ * lower g replaces the old node (and is reopened if it was explored), and
+ * the old copy is skipped when it is removed.  Returns 1 if the node was added */
+int add_open_node(NodeTable* table, BucketQueue* open_list, Histogram* f_hist, PackedNode node, int weight){
+	PackedNode* found = table_find(table, node.state);
+	if(found == NULL){                       // node is not in the open or closed set, add it to open_list
+		if(table_insert(table, node) == NULL){ // no room left, dropped like a shed node
+			if(node.g + node.h < shed_f) shed_f = node.g + node.h;
+			return 0;
+		}
+	} else if(found->g > node.g){            // reached with a worse solution before, replace it
+		*found = node;
+		note_change(node.state);
+	} else {
+		return 0;
+	}
+	queue_push(open_list, node_key(&node, weight), node);
+	histogram_add(f_hist, node.g + node.h);
+	return 1;
+}
+
+/* Allocates the distributed closed set (collective): each proc exposes
+ * a segment of 'entries' (state, g) pairs in an MPI window, rounded up to
+ * a power of 2.  When every proc is on one node the window is a shared
+ * one: Open MPI then serves the atomics from shared memory (osc sm), while
+ * its default component (osc rdma) emulates them through the shared memory
+ * transport and crashes in Open MPI 4.1.  The window stays locked by every
+ * proc until destroy_closed(), so closed_claim() only needs one-sided
+ * operations */
+DistClosed* make_closed(long entries, int nprocs){
+	DistClosed* dc = malloc(sizeof(DistClosed));
+	assert(dc);
+	dc->entries = 1;
+	while(dc->entries < (size_t)entries) dc->entries *= 2;
+	dc->nprocs = nprocs;
+	dc->skipped = 0;
+	size_t bytes = dc->entries * 2 * sizeof(uint64_t); // fixed, so not counted against the memory budget
+	MPI_Comm node_comm;
+	int node_procs;
+	MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+	MPI_Comm_size(node_comm, &node_procs);
+	MPI_Comm_free(&node_comm);
+	if(node_procs == nprocs){                // same answer on every proc
+		MPI_Win_allocate_shared(bytes, sizeof(uint64_t), MPI_INFO_NULL, MPI_COMM_WORLD, &dc->slots, &dc->win);
+	} else {
+		MPI_Win_allocate(bytes, sizeof(uint64_t), MPI_INFO_NULL, MPI_COMM_WORLD, &dc->slots, &dc->win);
+	}
+	memset(dc->slots, 0, bytes);
+	MPI_Win_lock_all(0, dc->win);
+	MPI_Win_sync(dc->win);
+	MPI_Barrier(MPI_COMM_WORLD);             // every segment is empty before anyone claims a state
+	return dc;
+}
+
+/* Frees the distributed closed set (collective) */
+void destroy_closed(DistClosed* dc){
+	MPI_Win_unlock_all(dc->win);
+	MPI_Win_free(&dc->win);
+	free(dc);
+}
+
+/* Checks whether any proc has explored 'state' with a g at least as low
+ * before this proc explores it, and records it if not, without involving
+ * the proc that holds it.  The state's home is a slot on the proc chosen
+ * by its hash.  MPI_Compare_and_swap takes the slot if it is empty
+ * (linear probing up to CLOSED_PROBES slots), then MPI_Fetch_and_op with
+ * MPI_MAX stores CLOSED_DEPTH - g (never 0, PackedNode.g has 16 bits), so
+ * the lowest g wins even when two procs claim the state at once.  Returns 1 if the caller should explore the
+ * state (also when its slots are all taken by other states) and 0 if
+ * another proc already did */
+int closed_claim(DistClosed* dc, uint64_t state, int g){
+	uint64_t hash = hash_state(state);
+	int owner = (int)((hash >> 40) % dc->nprocs);
+	size_t mask = dc->entries - 1;
+	uint64_t empty = 0;
+	for(int probe = 0; probe < CLOSED_PROBES; probe++){
+		MPI_Aint slot = (MPI_Aint)(((hash + probe) & mask) * 2);
+		uint64_t found;
+		MPI_Compare_and_swap(&state, &empty, &found, MPI_UINT64_T, owner, slot, dc->win);
+		MPI_Win_flush(owner, dc->win);
+		if(found != 0 && found != state) continue; // taken by another state
+		uint64_t value = CLOSED_DEPTH - g;
+		uint64_t previous;
+		MPI_Fetch_and_op(&value, &previous, MPI_UINT64_T, owner, slot + 1, MPI_MAX, dc->win);
+		MPI_Win_flush(owner, dc->win);
+		if(previous >= value){           // explored with a g at least as low
+			dc->skipped++;
+			return 0;
+		}
+		return 1;
+	}
+	return 1;
+}
+
+/* Allocates the work stealing state of one proc */
+Stealer* make_stealer(int rank, int nprocs){
+	Stealer* st = malloc(sizeof(Stealer));
+	assert(st);
+	st->waiting = 0;
+	st->replies_sent = 0;
+	st->replies_received = 0;
+	st->requests_sent = calloc(nprocs, sizeof(int));
+	st->requests_received = 0;
+	st->seed = 2463534242u + 7919u * rank;   // each proc picks a different sequence of victims
+	st->pending = 0;
+	st->pending_capacity = 16;
+	st->sends = malloc(st->pending_capacity * sizeof(MPI_Request));
+	st->buffers = malloc(st->pending_capacity * sizeof(void*));
+	assert(st->requests_sent && st->sends && st->buffers);
+	return st;
+}
+
+/* Frees the buffers of replies that have been sent */
+void steal_cleanup(Stealer* st){
+	int kept = 0;
+	for(int i = 0; i < st->pending; i++){
+		int done;
+		MPI_Test(&st->sends[i], &done, MPI_STATUS_IGNORE);
+		if(done){
+			free(st->buffers[i]);
+		} else {
+			st->sends[kept] = st->sends[i];
+			st->buffers[kept++] = st->buffers[i];
+		}
+	}
+	st->pending = kept;
+}
+
+/* Sends a reply of 'count' nodes (which may be 0) to a proc that asked for
+ * work.  The buffer is freed by steal_cleanup() once the send is done */
+void steal_reply(Stealer* st, int thief, PackedNode* nodes, int count){
+	steal_cleanup(st);
+	if(st->pending == st->pending_capacity){
+		st->pending_capacity *= 2;
+		st->sends = realloc(st->sends, st->pending_capacity * sizeof(MPI_Request));
+		st->buffers = realloc(st->buffers, st->pending_capacity * sizeof(void*));
+		assert(st->sends && st->buffers);
+	}
+	MPI_Isend(nodes, count * sizeof(PackedNode), MPI_BYTE, thief, TAG_STEAL_REPLY, MPI_COMM_WORLD, &st->sends[st->pending]);
+	st->buffers[st->pending++] = nodes;
+	if(count > 0) st->replies_sent++;
+}
+
+/* Answers a request for work from another proc.  If this proc has at least
+ * twice options.steal_batch open nodes, it takes its 2*steal_batch best nodes
+ * and gives away every other one, so both procs get some of the best nodes.
+ * The nodes given away are marked closed in this proc's table, like in
+ * split_open_list().  Otherwise it replies with no nodes */
+void steal_give(Stealer* st, int thief, NodeTable* table, BucketQueue* open_list, Histogram* f_hist, int weight){
+	int batch = options.steal_batch;
+	PackedNode* nodes = malloc(batch * sizeof(PackedNode));
+	assert(nodes);
+	int count = 0;
+	if(open_list->size >= (size_t)batch * 2){
+		PackedNode* kept = malloc(batch * sizeof(PackedNode));
+		assert(kept);
+		int kept_count = 0;
+		PackedNode node;
+		while(count < batch && queue_pop(open_list, &node) != -1){
+			histogram_remove(f_hist, node.g + node.h);
+			PackedNode* entry = table_find(table, node.state);
+			if(entry == NULL || (entry->move & MOVE_CLOSED) || entry->g < node.g) continue; // stale copy, or shed
+			if(kept_count <= count && kept_count < batch){
+				kept[kept_count++] = node;
+			} else {
+				entry->move |= MOVE_CLOSED;  // owned by the thief now
+				entry->given = 1;
+				note_change(entry->state);
+				nodes[count++] = node;
+			}
+		}
+		for(int i = 0; i < kept_count; i++){
+			queue_push(open_list, node_key(&kept[i], weight), kept[i]);
+			histogram_add(f_hist, kept[i].g + kept[i].h);
+		}
+		free(kept);
+	}
+	steal_reply(st, thief, nodes, count);
+}
+
+/* Handles every work stealing message that has arrived: requests from other
+ * procs are answered with steal_give(), and the nodes in a reply to this
+ * proc's request are added to its open list with add_open_node().  A node
+ * this proc gave away with the same g (steal_give(), split_open_list()) and
+ * that was passed back is reopened rather than dropped */
+void steal_poll(Stealer* st, NodeTable* table, BucketQueue* open_list, Histogram* f_hist, int weight){
+	int flag = 1;
+	while(flag){
+		MPI_Status status;
+		MPI_Iprobe(MPI_ANY_SOURCE, TAG_STEAL_REQUEST, MPI_COMM_WORLD, &flag, &status);
+		if(flag){
+			int unused;
+			MPI_Recv(&unused, 1, MPI_INT, status.MPI_SOURCE, TAG_STEAL_REQUEST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			st->requests_received++;
+			steal_give(st, status.MPI_SOURCE, table, open_list, f_hist, weight);
+		}
+	}
+	if(st->waiting){
+		MPI_Status status;
+		MPI_Iprobe(MPI_ANY_SOURCE, TAG_STEAL_REPLY, MPI_COMM_WORLD, &flag, &status);
+		if(flag){
+			int size;
+			MPI_Get_count(&status, MPI_BYTE, &size);
+			int count = size / sizeof(PackedNode);
+			PackedNode* nodes = malloc((count > 0 ? count : 1) * sizeof(PackedNode));
+			assert(nodes);
+			MPI_Recv(nodes, size, MPI_BYTE, status.MPI_SOURCE, TAG_STEAL_REPLY, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			for(int i = 0; i < count; i++){
+				PackedNode* found = table_find(table, nodes[i].state);
+				if(found != NULL && found->g == nodes[i].g && found->given){
+					*found = nodes[i];       // given away by this proc earlier and handed back, take it again
+					note_change(found->state);
+					queue_push(open_list, node_key(&nodes[i], weight), nodes[i]);
+					histogram_add(f_hist, nodes[i].g + nodes[i].h);
+				} else {
+					add_open_node(table, open_list, f_hist, nodes[i], weight);
+				}
+			}
+			if(count > 0) st->replies_received++;
+			st->waiting = 0;
+			free(nodes);
+		}
+	}
+}
+
+/* Asks a randomly chosen proc for work if this proc has no request waiting
+ * and is running low: fewer than options.steal_low open nodes, or (with
+ * --optimal) no open node as good as the best one on any proc at the last
+ * check, 'global_min_f' */
+void steal_request(Stealer* st, BucketQueue* open_list, Histogram* f_hist, int global_min_f, int rank, int nprocs){
+	if(st->waiting || nprocs == 1) return;
+	int low = open_list->size < (size_t)options.steal_low;
+	int poor = options.optimal && f_hist->min > global_min_f;
+	if(!low && !poor) return;
+	st->seed ^= st->seed << 13;              // xorshift random number for the victim
+	st->seed ^= st->seed >> 17;
+	st->seed ^= st->seed << 5;
+	int victim = st->seed % (nprocs - 1);
+	if(victim >= rank) victim++;             // any proc but this one
+	int unused = 0;
+	MPI_Send(&unused, 1, MPI_INT, victim, TAG_STEAL_REQUEST, MPI_COMM_WORLD);
+	st->requests_sent[victim]++;
+	st->waiting = 1;
+}
+
+/* Answers every request still on its way with no nodes, waits for the reply
+ * to this proc's own request, and completes all sends, so no messages are
+ * left over when the search ends (collective).  Frees the Stealer.  Only
+ * called once no reply with nodes is in flight */
+void steal_finish(Stealer* st, int rank, int nprocs){
+	int* totals = malloc(nprocs * sizeof(int));
+	assert(totals);
+	MPI_Allreduce(st->requests_sent, totals, nprocs, MPI_INT, MPI_SUM, MPI_COMM_WORLD); // totals[r] is the number sent to r
+	while(st->requests_received < totals[rank]){
+		int unused;
+		MPI_Status status;
+		MPI_Recv(&unused, 1, MPI_INT, MPI_ANY_SOURCE, TAG_STEAL_REQUEST, MPI_COMM_WORLD, &status);
+		st->requests_received++;
+		steal_reply(st, status.MPI_SOURCE, malloc(sizeof(PackedNode)), 0);
+	}
+	if(st->waiting){                         // the reply has no nodes, they would have been counted as in flight
+		PackedNode unused;
+		MPI_Recv(&unused, sizeof(PackedNode), MPI_BYTE, MPI_ANY_SOURCE, TAG_STEAL_REPLY, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	MPI_Waitall(st->pending, st->sends, MPI_STATUSES_IGNORE);
+	for(int i = 0; i < st->pending; i++){
+		free(st->buffers[i]);
+	}
+	free(totals);
+	free(st->requests_sent);
+	free(st->sends);
+	free(st->buffers);
+	free(st);
+}
+
+/* Returns 1 if every reply to a request for work has been received, so no
+ * open nodes are on their way between procs (collective).  Always 1
+ * without work stealing */
+int steal_settled(Stealer* st, int nprocs){
+	if(options.steal_low == 0 || nprocs == 1) return 1;
+	int replies[2] = { st->replies_sent, st->replies_received };
+	int totals[2];
+	MPI_Allreduce(replies, totals, 2, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+	return totals[0] == totals[1];
+}
+
+/* Prepares the --partial expansion (enhanced partial expansion, EPEA*) of
+ * a node in a_star_search().  The h of each child is found without
+ * generating it, from operator_delta_f with the Manhattan Distance (the
+ * pattern database has no such table, so the child's h is looked up), and
+ * stored in hs[] (-1 for impossible moves).  The node's priority in the open
+ * list was node_key() + key_offset, and only the children with that priority
+ * are generated now, or on its first expansion every child up to it: *low
+ * and *high are set to the range of priorities to generate.  Returns the
+ * lowest priority of a child left for a later expansion, or INT_MAX if
+ * none is left (or without --partial, where every child is generated) */
+int partial_bounds(PackedNode* node, int blank, int weight, int hs[4], int* low, int* high){
+	if(!options.partial) return INT_MAX;
+	int base = node_key(node, weight);
+	int bound = base + node->key_offset;
+	int next = INT_MAX;
+	for(int move = 0; move < 4; move++){
+		hs[move] = -1;
+		if(!move_possible(blank, move)) continue;
+		if(pdb != NULL){
+			hs[move] = pdb_heuristic(pdb, packed_move(node->state, blank, move));
+		} else {
+			int tile = packed_tile(node->state, blank + move_delta[move]);
+			hs[move] = node->h + operator_delta_f[tile][blank][move] - 1;
+		}
+		int key = key_of(node->g + 1, hs[move], weight);
+		if(key > bound && key < next) next = key;
+	}
+	*low = node->key_offset == 0 ? -1 : bound - 1; // no child has a priority between the last expansion's and 'bound'
+	*high = bound;
+	if(next != INT_MAX && next - base > UINT8_MAX){ // the offset does not fit, generate the rest now
+		*high = INT_MAX;
+		next = INT_MAX;
+	}
+	return next;
+}
+
+/* Sets 'path' to the checkpoint file of the given proc in the set whose
+ * first segment has generation 'base' */
+void checkpoint_path(char* path, size_t size, int64_t base, int proc){
+	snprintf(path, size, "%s.%ld.%d", options.checkpoint, (long)base, proc);
+}
+
+/* Sets 'path' to the manifest naming the current set of checkpoint files,
+ * with ".tmp" added while it is being written */
+void manifest_path(char* path, size_t size, int tmp){
+	snprintf(path, size, "%s.manifest%s", options.checkpoint, tmp ? ".tmp" : "");
+}
+
+/* Reads the checkpoint manifest into 'manifest'.  Returns 0 on success and
+ * -1 if it is missing or is not a manifest */
+int manifest_read(CheckpointManifest* manifest){
+	char path[4096];
+	manifest_path(path, sizeof(path), 0);
+	FILE* file = fopen(path, "rb");
+	if(file == NULL) return -1;
+	size_t read = fread(manifest, sizeof(CheckpointManifest), 1, file);
+	fclose(file);
+	return read == 1 && manifest->magic == MANIFEST_MAGIC ? 0 : -1;
+}
+
+/* Compares two states for qsort */
+int compare_u64(const void* a, const void* b){
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+/* Allocates the checkpoint state of one proc.  'base' is the generation
+ * of the first segment of the new set of files, and 'old' the manifest of
+ * the set it replaces (NULL for none) */
+Checkpointer* make_checkpointer(int64_t base, CheckpointManifest* old){
+	Checkpointer* ckpt = malloc(sizeof(Checkpointer));
+	assert(ckpt);
+	ckpt->stream = NULL;
+	ckpt->base = base;
+	ckpt->generation = base - 1;
+	ckpt->old_base = old != NULL ? old->base : 0;
+	ckpt->old_nprocs = old != NULL ? old->nprocs : 0;
+	ckpt->changes.states = NULL;
+	ckpt->changes.size = 0;
+	ckpt->changes.capacity = 0;
+	ckpt->failed = 0;
+	return ckpt;
+}
+
+/* Waits for the last segment to be written, closes this proc's checkpoint
+ * file and frees the checkpoint state */
+void checkpoint_finish(Checkpointer* ckpt){
+	if(changed_states == &ckpt->changes) changed_states = NULL;
+	if(ckpt->stream != NULL) disk_close(ckpt->stream);
+	free(ckpt->changes.states);
+	free(ckpt);
+}
+
+/* Puts a segment header into this proc's checkpoint file */
+void checkpoint_put_header(DiskStream* stream, CheckpointHeader* header){
+	PackedNode records[CHECKPOINT_RECORDS] = { { 0 } };
+	memcpy(records, header, sizeof(CheckpointHeader));
+	for(size_t i = 0; i < CHECKPOINT_RECORDS; i++){
+		disk_put(stream, records[i]);
+	}
+}
+
+/* Starts a new set of checkpoint files (collective): every proc writes its
+ * whole table as the first segment of its file, and once every proc is
+ * done proc 0 replaces the manifest with one naming the new set, and the
+ * files of the old set are deleted.  A job killed before the manifest is
+ * replaced still has the old set.  If a proc cannot write its file, no
+ * proc writes checkpoints after this one */
+void checkpoint_start_set(NodeTable* table, CheckpointHeader* header, Checkpointer* ckpt, int rank, int nprocs){
+	char path[4096];
+	checkpoint_path(path, sizeof(path), ckpt->base, rank);
+	remove(path);                            // disk_open() appends
+	DiskStream* stream = disk_open(path, 1, options.disk_buffer);
+	if(stream != NULL){
+		header->generation = ckpt->base;
+		header->nodes = table->size;
+		checkpoint_put_header(stream, header);
+		for(size_t i = 0; i < table->capacity; i++){
+			if(table->slots[i].state != 0) disk_put(stream, table->slots[i]);
+		}
+		if(disk_flush(stream, 1) != 0){
+			disk_close(stream);
+			stream = NULL;
+		}
+	}
+	int ok = stream != NULL;
+	int all_ok;
+	MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD); // every proc has a complete file
+	if(!all_ok){
+		if(stream != NULL) disk_close(stream);
+		remove(path);
+		if(rank == 0) printf("could not write the checkpoint files %s, going on without checkpoints\n", options.checkpoint);
+		ckpt->failed = 1;
+		return;
+	}
+	if(rank == 0){
+		CheckpointManifest manifest = { MANIFEST_MAGIC, header->start_state, header->goal_state, ckpt->base, nprocs, 0 };
+		char tmp[4096], final[4096];
+		manifest_path(tmp, sizeof(tmp), 1);
+		manifest_path(final, sizeof(final), 0);
+		FILE* file = fopen(tmp, "wb");
+		int written = file != NULL && fwrite(&manifest, sizeof(manifest), 1, file) == 1;
+		if(file != NULL && fclose(file) != 0) written = 0;
+		if(written) written = rename(tmp, final) == 0;
+		if(!written) printf("could not write the checkpoint manifest %s, going on without checkpoints\n", final);
+		ok = written;
+	}
+	MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	if(!ok){
+		disk_close(stream);
+		remove(path);
+		ckpt->failed = 1;
+		return;
+	}
+	for(int proc = rank; proc < ckpt->old_nprocs; proc += nprocs){ // the manifest no longer names them
+		checkpoint_path(path, sizeof(path), ckpt->old_base, proc);
+		remove(path);
+	}
+	ckpt->stream = stream;
+	ckpt->generation = ckpt->base;
+	ckpt->changes.size = 0;
+	changed_states = &ckpt->changes;         // from now on only changes are written
+}
+
+/* Saves this proc's part of the search as a new segment of its checkpoint
+ * file.  The first checkpoint of a run writes every node of the table
+ * (checkpoint_start_set(), collective); later ones append a segment with
+ * only the nodes added or changed since the last one (see note_change()),
+ * which is handed to the DiskStream's I/O thread while the search goes on.
+ * Each segment is a CheckpointHeader with the next generation followed by
+ * its nodes.  A segment cut short by a killed job is ignored by
+ * checkpoint_load(), which uses the last generation every file has in
+ * full.  Every proc must call it at the same iteration.  Returns 1 if the
+ * checkpoint was written (or checkpoints are off after an error) and 0 if
+ * it was put off because stolen nodes were on their way (they would be in
+ * no file) */
+int checkpoint_save(NodeTable* table, CheckpointHeader* header, Stealer* stealer, Checkpointer* ckpt, int rank, int nprocs){
+	if(header->split && options.steal_low > 0 && nprocs > 1){
+		int replies[2] = { stealer->replies_sent, stealer->replies_received };
+		int totals[2];
+		MPI_Allreduce(replies, totals, 2, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+		if(totals[0] != totals[1]) return 0;
+	}
+	header->magic = CHECKPOINT_MAGIC;
+	header->nprocs = nprocs;
+	header->rank = rank;
+	if(ckpt->failed) return 1;
+	if(ckpt->stream == NULL){
+		checkpoint_start_set(table, header, ckpt, rank, nprocs);
+		return 1;
+	}
+
+	ChangeLog* log = &ckpt->changes;         // write each changed state once, as it is now
+	qsort(log->states, log->size, sizeof(uint64_t), compare_u64);
+	size_t count = 0;
+	for(size_t i = 0; i < log->size; i++){   // a state shed since it changed is left out
+		if((count == 0 || log->states[i] != log->states[count - 1]) && table_find(table, log->states[i]) != NULL) log->states[count++] = log->states[i];
+	}
+	header->generation = ckpt->generation + 1;
+	header->nodes = count;
+	checkpoint_put_header(ckpt->stream, header);
+	for(size_t i = 0; i < count; i++){
+		disk_put(ckpt->stream, *table_find(table, log->states[i]));
+	}
+	log->size = 0;
+	if(disk_flush(ckpt->stream, 0) != 0){   // an earlier segment could not be written
+		printf("proc %d could not write its checkpoint file, going on without checkpoints\n", rank);
+		ckpt->failed = 1;
+		changed_states = NULL;
+	} else {
+		ckpt->generation++;
+	}
+	return 1;
+}
+
+/* Reads the segment headers of the given proc's file in the checkpoint set
+ * named by 'manifest', skipping over the nodes.  If a complete segment has
+ * generation 'want', its header is copied into 'header'.  Returns the last
+ * generation the file has in full, or -1 if the file is missing or its
+ * first segment does not belong to the set */
+int64_t checkpoint_scan(CheckpointManifest* manifest, int proc, int64_t want, CheckpointHeader* header){
+	char path[4096];
+	checkpoint_path(path, sizeof(path), manifest->base, proc);
+	FILE* file = fopen(path, "rb");
+	if(file == NULL) return -1;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	int64_t last = -1;
+	PackedNode records[CHECKPOINT_RECORDS];
+	CheckpointHeader segment;
+	long offset = 0;
+	while(fread(records, sizeof(PackedNode), CHECKPOINT_RECORDS, file) == CHECKPOINT_RECORDS){
+		memcpy(&segment, records, sizeof(CheckpointHeader));
+		if(segment.magic != CHECKPOINT_MAGIC || segment.rank != proc || segment.nprocs != manifest->nprocs
+				|| segment.start_state != manifest->start_state || segment.goal_state != manifest->goal_state
+				|| segment.generation != (last == -1 ? manifest->base : last + 1)) break;
+		offset += sizeof(records) + segment.nodes * sizeof(PackedNode);
+		if(offset > size) break;             // cut short
+		last = segment.generation;
+		if(last == want) *header = segment;
+		fseek(file, offset, SEEK_SET);
+	}
+	fclose(file);
+	return last;
+}
+
+/* Loads the given proc's checkpoint file up to generation 'target' into
+ * 'into': a later segment's copy of a state replaces an earlier one, as
+ * the later one is the same node after it changed */
+void checkpoint_read(CheckpointManifest* manifest, int proc, int64_t target, NodeTable* into){
+	char path[4096];
+	checkpoint_path(path, sizeof(path), manifest->base, proc);
+	DiskStream* stream = disk_open(path, 0, options.disk_buffer);
+	assert(stream);                          // checkpoint_scan() found it
+	for(int64_t generation = manifest->base; generation <= target; generation++){
+		PackedNode records[CHECKPOINT_RECORDS];
+		CheckpointHeader segment;
+		for(size_t i = 0; i < CHECKPOINT_RECORDS; i++){
+			int got = disk_get(stream, &records[i]);
+			assert(got);
+		}
+		memcpy(&segment, records, sizeof(CheckpointHeader));
+		for(uint64_t i = 0; i < segment.nodes; i++){
+			PackedNode node;
+			int got = disk_get(stream, &node);
+			assert(got);
+			PackedNode* found = table_find(into, node.state);
+			if(found == NULL){
+				table_insert(into, node);
+			} else {
+				*found = node;
+			}
+		}
+	}
+	disk_close(stream);
+}
+
+/* Returns how checkpoint_load() ranks copies of a state with the same g:
+ * 2 for an explored copy (its children were saved too), 1 for an open one
+ * and 0 for one given unexplored to another proc, which holds it as open or
+ * explored */
+int checkpoint_preference(PackedNode* node){
+	if(node->given) return 0;
+	return (node->move & MOVE_CLOSED) ? 2 : 1;
+}
+
+/* Compares the g of two PackedNodes for qsort */
+int compare_depths(const void* a, const void* b){
+	return ((const PackedNode*)a)->g - ((const PackedNode*)b)->g;
+}
+
+/* Resumes a search from the checkpoint set named by the manifest of
+ * options.checkpoint (collective).  It loads the last generation that
+ * every file of the set has in full, so the files always describe the
+ * same iteration, even if the job was killed while some procs were still
+ * appending a segment.  The files may come from a run with a different number of
+ * procs: proc r loads the files of old procs r, r + nprocs, r + 2*nprocs...
+ * and the rank of each node's parent is mapped the same way, so the path
+ * can still be traced across procs.  A state found in two files keeps the
+ * copy with the lower g, or with the same g the one checkpoint_preference()
+ * ranks higher.  If the old run had not split its open list yet, every
+ * proc loads proc 0's file.  The open nodes are pushed onto open_list in
+ * order of g, so as in the old run the deepest of a priority comes out
+ * first, and 'header' gets the counters of the old run ('explored',
+ * 'found_cost' and 'shed_f' over the loaded files) and the generation
+ * loaded.  A node shed after an older segment saved it comes back open
+ * from that segment, which only repeats some work.  Returns 0
+ * on success, or -1 on every proc, with nothing loaded, if the manifest or
+ * any file of the set is missing or does not match */
+int checkpoint_load(NodeTable* table, BucketQueue* open_list, Histogram* f_hist, int weight, CheckpointHeader* header, CheckpointManifest* manifest, uint64_t start_state, uint64_t goal_state, int rank, int nprocs){
+	int ok = manifest_read(manifest) == 0 && manifest->start_state == start_state && manifest->goal_state == goal_state;
+	int64_t target = INT64_MAX;              // last generation every file has in full
+	for(int proc = 0; ok && proc < manifest->nprocs; proc++){
+		int64_t last = checkpoint_scan(manifest, proc, -1, NULL);
+		if(last < 0) ok = 0;
+		if(last < target) target = last;
+	}
+	int64_t local = ok ? target : -1;        // every proc must load the same generation
+	MPI_Allreduce(&local, &target, 1, MPI_INT64_T, MPI_MIN, MPI_COMM_WORLD);
+	CheckpointHeader first;
+	first.generation = -1;
+	if(ok) checkpoint_scan(manifest, 0, target, &first);
+	ok = ok && first.generation == target;
+	int all_ok;
+	MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+	if(!all_ok) return -1;
+
+	*header = first;
+	header->explored = 0;
+	header->found_cost = INT_MAX;
+	header->shed_f = INT_MAX;
+	for(int proc = first.split ? rank : 0; proc < manifest->nprocs; proc += first.split ? nprocs : manifest->nprocs){
+		CheckpointHeader file_header;
+		checkpoint_scan(manifest, proc, target, &file_header);
+		header->explored += file_header.explored;
+		if(file_header.found_cost < header->found_cost) header->found_cost = file_header.found_cost;
+		if(file_header.shed_f < header->shed_f) header->shed_f = file_header.shed_f;
+		NodeTable* file_table = make_table(1 << 16);
+		checkpoint_read(manifest, proc, target, file_table);
+		for(size_t i = 0; i < file_table->capacity; i++){
+			PackedNode node = file_table->slots[i];
+			if(node.state == 0) continue;
+			node.parent_rank = first.split ? node.parent_rank % nprocs : rank;
+			PackedNode* found = table_find(table, node.state);
+			if(found == NULL){
+				table_insert(table, node);
+			} else if(found->g > node.g || (found->g == node.g && checkpoint_preference(&node) > checkpoint_preference(found))){
+				*found = node;
+			}
+		}
+		destroy_table(file_table);
+	}
+	size_t count = 0;                        // open nodes, gathered so they can be pushed in order of g
+	for(size_t i = 0; i < table->capacity; i++){
+		if(table->slots[i].state != 0 && !(table->slots[i].move & MOVE_CLOSED)) count++;
+	}
+	PackedNode* open = malloc((count > 0 ? count : 1) * sizeof(PackedNode));
+	assert(open);
+	count = 0;
+	for(size_t i = 0; i < table->capacity; i++){
+		if(table->slots[i].state != 0 && !(table->slots[i].move & MOVE_CLOSED)) open[count++] = table->slots[i];
+	}
+	qsort(open, count, sizeof(PackedNode), compare_depths); // a bucket is LIFO, the last pushed comes out first
+	for(size_t i = 0; i < count; i++){
+		queue_push(open_list, node_key(&open[i], weight), open[i]);
+		histogram_add(f_hist, open[i].g + open[i].h);
+	}
+	free(open);
+	return 0;
+}
+
+/* Allocates the cancellation state of one proc of portfolio_search() */
+Race* make_race(int nprocs){
+	Race* race = malloc(sizeof(Race));
+	assert(race);
+	race->cancelled = 0;
+	race->sent = 0;
+	race->polls = 0;
+	race->requests = malloc(nprocs * sizeof(MPI_Request));
+	assert(race->requests);
+	return race;
+}
+
+/* Returns 1 if another proc has finished the race (never for a NULL race),
+ * checked inside the search loops.  Only every RACE_POLL-th call looks for a cancel message
+ * (MPI_Iprobe, which does not block), so the check costs almost nothing */
+int race_cancelled(Race* race){
+	if(race == NULL) return 0;
+	if(race->cancelled || ++race->polls % RACE_POLL != 0) return race->cancelled;
+	int flag;
+	MPI_Iprobe(MPI_ANY_SOURCE, TAG_CANCEL, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+	race->cancelled = flag;
+	return flag;
+}
+
+/* Tells every other proc to stop, without waiting for them */
+void race_cancel(Race* race, int rank, int nprocs){
+	race->sent = 1;
+	for(int i = 0; i < nprocs; i++){
+		if(i == rank){
+			race->requests[i] = MPI_REQUEST_NULL;
+		} else {
+			MPI_Isend(&race->sent, 1, MPI_INT, i, TAG_CANCEL, MPI_COMM_WORLD, &race->requests[i]);
+		}
+	}
+}
+
+/* Receives every cancel message sent to this proc (collective: more than
+ * one proc may finish before it hears of the others), so none is left
+ * over, then completes the ones it sent and frees the race.  The receives
+ * come first so the sends never depend on being buffered by MPI */
+void race_finish(Race* race, int nprocs){
+	int senders;
+	MPI_Allreduce(&race->sent, &senders, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+	for(int i = 0; i < senders - race->sent; i++){
+		int flag;
+		MPI_Recv(&flag, 1, MPI_INT, MPI_ANY_SOURCE, TAG_CANCEL, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	if(race->sent) MPI_Waitall(nprocs, race->requests, MPI_STATUSES_IGNORE);
+	free(race->requests);
+	free(race);
+}
+
+/* Best-first search for portfolio_search(), ordered by node_key() with the
+ * strategy's weight, that stops early if the race is cancelled.  Stores
+ * the moves in 'result'.  Returns 1 if a solution was found */
+int race_best_first(RaceStrategy* strategy, Race* race, uint64_t start_state, uint64_t goal_state, ServeResult* result){
+	int weight = scale_weight(strategy->weight);
+	NodeTable* table = make_table(1 << 16);
+	BucketQueue* open_list = make_queue(key_priorities(weight));
+	Histogram f_hist;
+	init_histogram(&f_hist);
+	PackedNode first = make_packed_node(start_state, 0, heuristic(start_state), MOVE_ROOT, packed_blank(start_state));
+	table_insert(table, first);
+	queue_push(open_list, node_key(&first, weight), first);
+
+	PackedNode current;
+	while(!race_cancelled(race) && queue_pop(open_list, &current) != -1){
+		PackedNode* entry = table_find(table, current.state);
+		if((entry->move & MOVE_CLOSED) || entry->g < current.g) continue; // stale copy
+		entry->move |= MOVE_CLOSED;
+		result->explored++;
+		if(current.state == goal_state){ // store the moves, start first
+			result->steps = current.g;
+			for(int i = current.g - 1; i >= 0; i--){
+				int move = entry->move & MOVE_MASK;
+				result->moves[i] = move;
+				entry = table_find(table, packed_move(entry->state, node_blank(entry), move ^ 1));
+			}
+			break;
+		}
+		if(current.g + 1 >= MAX_PATH) continue;
+		int blank = node_blank(&current);
+		for(int i = 0; i < 4; i++){
+			int move = strategy->reversed ? 3 - i : i;
+			if(!move_possible(blank, move)) continue;
+			uint64_t state = packed_move(current.state, blank, move);
+			int h = child_heuristic(current.state, current.h, blank, move, state);
+			add_open_node(table, open_list, &f_hist, make_packed_node(state, current.g + 1, h, move, blank + move_delta[move]), weight);
+		}
+	}
+	destroy_table(table);
+	destroy_queue(open_list);
+	return result->steps >= 0;
+}
+
+/* Depth-first search of race_ida() below a state reached with g moves,
+ * pruning children whose f = g + h is above the bound.  'fsm' is the FSM
+ * node of the moves so far, and moves the FSM prunes are skipped.  A state
+ * the transposition table already holds from this iteration with a g at
+ * least as low is skipped too: its subtree was searched with at least as
+ * many moves to spare.  The lowest f above the bound is kept in
+ * ida->next_bound.  Returns 1 if the goal was found (ida->result->moves
+ * holds the path), -1 if the race was cancelled and 0 otherwise */
+int ida_search(IdaSearch* ida, uint64_t state, int h, int g, int fsm){
+	if(state == ida->goal_state){
+		ida->result->steps = g;
+		return 1;
+	}
+	if(race_cancelled(ida->race)) return -1;
+	if(ida->tt != NULL){
+		TableEntry* entry = &ida->tt[hash_state(state) & ida->tt_mask];
+		if(entry->state == state && entry->bound == ida->bound && entry->g <= g){
+			ida->tt_pruned++;
+			return 0;
+		}
+		entry->state = state;            // always replace, the table is lossy
+		entry->g = g;
+		entry->bound = ida->bound;
+	}
+	ida->result->explored++;
+	int blank = packed_blank(state);
+	for(int move = 0; move < 4; move++){
+		if(!move_possible(blank, move) || fsm_next[fsm][move] < 0) continue;
+		uint64_t child = packed_move(state, blank, move);
+		int child_h = child_heuristic(state, h, blank, move, child);
+		if(g + 1 + child_h > ida->bound){
+			if(g + 1 + child_h < ida->next_bound) ida->next_bound = g + 1 + child_h;
+			continue;
+		}
+		ida->result->moves[g] = move;
+		int found = ida_search(ida, child, child_h, g + 1, fsm_next[fsm][move]);
+		if(found != 0) return found;
+	}
+	return 0;
+}
+
+/* Iterative deepening A*: depth-first searches with a growing bound on f,
+ * starting at 'min_bound' if it is above h of the start board (it must not
+ * be above the solution cost, or the solution may not be optimal).
+ * Besides the path it only uses the transposition table (options.tt_entries
+ * entries), so memory does not grow with the search.  The first solution is
+ * optimal.  The number of pruned nodes is added to 'tt_pruned' if it is not
+ * NULL.  Returns 1 if a solution was found */
+int race_ida(Race* race, uint64_t start_state, uint64_t goal_state, int min_bound, ServeResult* result, long* tt_pruned){
+	IdaSearch ida;
+	ida.goal_state = goal_state;
+	ida.race = race;
+	ida.result = result;
+	ida.tt = NULL;
+	ida.tt_mask = 0;
+	ida.tt_pruned = 0;
+	if(options.tt_entries > 0){
+		size_t entries = 1;
+		while(entries < (size_t)options.tt_entries) entries *= 2;
+		ida.tt = calloc(entries, sizeof(TableEntry));
+		assert(ida.tt);
+		ida.tt_mask = entries - 1;
+	}
+	int h = heuristic(start_state);
+	int found = 0;
+	ida.bound = h > min_bound ? h : min_bound;
+	while(ida.bound < MAX_PATH){
+		ida.next_bound = INT_MAX;
+		found = ida_search(&ida, start_state, h, 0, 0);
+		if(found != 0 || ida.next_bound == INT_MAX) break;
+		ida.bound = ida.next_bound;
+	}
+	free(ida.tt);
+	if(tt_pruned != NULL) *tt_pruned += ida.tt_pruned;
+	return found == 1;
+}
+
+/* Prints a solution stored as moves of the 0 tile in 'result' with
+ * print_solution(), replaying the moves from the start board */
+void print_move_solution(Board* start, Board* goal, long iters, long explored, ServeResult* result){
+	uint64_t* path = malloc((result->steps + 1) * sizeof(uint64_t)); // goal first
+	assert(path);
+	uint64_t state = pack_board(start);
+	for(int i = 0; i < result->steps; i++){
+		state = packed_move(state, packed_blank(state), result->moves[i]);
+		path[result->steps - 1 - i] = state;
+	}
+	print_solution(start, goal, iters, explored, path, result->steps);
+	free(path);
+}
+
+/* Finishes a_star_search() with IDA* once shedding open nodes could not
+ * keep a proc within its memory budget, or the shed nodes are needed to
+ * go on (collective, the tables of a_star_search() must be freed first).
+ * The lowest f of any open or shed node, 'bound', is a lower bound on the
+ * solution cost, so IDA* starts there instead of redoing the iterations
+ * below it.
+ * IDA* runs on proc 0 and only needs memory for its transposition table.
+ * Returns 0 if a solution was found and -1 otherwise */
+int memory_fallback(Board* start, Board* goal, int bound, long iters, long explored, int rank){
+	long total_explored = 0;
+	int solved = 0;
+	MPI_Reduce(&explored, &total_explored, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	if(rank == 0){
+		if(memory_budget > 0){
+			printf("memory budget of %zu MB used up after %ld explored states, switching to IDA* from f = %d\n", memory_budget >> 20, total_explored, bound);
+		} else {                             // resumed from a checkpoint of a run that shed boards
+			printf("boards shed by the checkpointed run are needed after %ld explored states, switching to IDA* from f = %d\n", total_explored, bound);
+		}
+		ServeResult* result = malloc(sizeof(ServeResult));
+		assert(result);
+		result->steps = -1;
+		result->explored = 0;
+		solved = race_ida(NULL, pack_board(start), pack_board(goal), bound, result, NULL);
+		if(solved){
+			print_move_solution(start, goal, iters, total_explored + result->explored, result);
+			printf("SOLUTION FOUND BY IDA* ON PROC 0\n");
+			printf("SOLUTION IS OPTIMAL\n");
+		} else {
+			printf("\n----------SOLUTION NOT FOUND----------\n");
+		}
+		free(result);
+	}
+	MPI_Bcast(&solved, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	return solved ? 0 : -1;
+}
+
+/* Returns 1 if a state next to 'node' is in the table with 'node' as its
+ * parent, so a path may be traced through it (see trace_packed_path()) */
+int node_has_children(NodeTable* table, PackedNode* node){
+	int blank = node_blank(node);
+	for(int move = 0; move < 4; move++){
+		if(!move_possible(blank, move)) continue;
+		PackedNode* child = table_find(table, packed_move(node->state, blank, move));
+		if(child != NULL && !(child->move & MOVE_ROOT) && (child->move & MOVE_MASK) == move) return 1;
+	}
+	return 0;
+}
+
+/* Makes room in the table of a_star_search() once memory_low is set, by
+ * dropping the open nodes with the highest keys, worst bucket first, until
+ * the table is at most half full or half of the open list is gone.  A
+ * dropped node leaves the open list and the table, so it can be generated
+ * again, and shed_f keeps the lowest f of the dropped nodes: the search
+ * then only stops once that is no lower than the solution it proves, and
+ * switches to IDA* from it otherwise (see memory_fallback()).  The nodes
+ * of the lowest open f are kept, and so are the start, nodes with children
+ * in the table and nodes partly expanded by --partial, since paths are
+ * traced through them.  Stale copies are just removed.  Emptied buckets are freed.  Returns 1, with memory_low
+ * cleared, if the table is then at most 5/8 full and under 90% of the
+ * budget is in use */
+int shed_open_nodes(NodeTable* table, BucketQueue* open_list, Histogram* f_hist){
+	size_t target = open_list->size / 2;     // most copies to drop
+	size_t dropped = 0;
+	int min_f = f_hist->min;                 // the nodes of the lowest f are kept, so A* can finish that f
+	for(int priority = open_list->priorities - 1; priority >= 0 && dropped < target && table->size * 2 > table->capacity; priority--){
+		OpenList* bucket = open_list->buckets[priority];
+		if(bucket == NULL) continue;
+		for(size_t i = bucket->size; i-- > 0 && dropped < target;){
+			PackedNode node = bucket->nodes[i];
+			PackedNode* entry = table_find(table, node.state);
+			int stale = entry == NULL || (entry->move & MOVE_CLOSED) || entry->g < node.g;
+			if(!stale){
+				if(node.g + node.h <= min_f || node.key_offset != 0 || (entry->move & MOVE_ROOT) || node_has_children(table, entry)) continue;
+				if(node.g + node.h < shed_f) shed_f = node.g + node.h;
+				table_remove(table, entry);
+			}
+			open_remove(bucket, i);          // the last node, already looked at, takes its place
+			open_list->size--;
+			histogram_remove(f_hist, node.g + node.h);
+			dropped++;
+		}
+		if(bucket->size == 0){
+			destroy_open_list(bucket);
+			open_list->buckets[priority] = NULL;
+		}
+	}
+	int room = table->size * 8 <= table->capacity * 5 && (memory_budget == 0 || memory_used <= memory_budget / 10 * 9);
+	if(room) memory_low = 0;
+	return room;
+}
+
+/* Runs IDA* (race_ida()) on proc 0 and prints the solution, with the
+ * nodes the transposition table pruned and the size of the move pruning
+ * FSM.  Returns 0 if a solution was found and -1 otherwise */
+int ida_star_search(Board* start, Board* goal){
+	ServeResult* result = malloc(sizeof(ServeResult));
+	assert(result);
+	result->steps = -1;
+	result->explored = 0;
+	long tt_pruned = 0;
+	int solved = race_ida(NULL, pack_board(start), pack_board(goal), 0, result, &tt_pruned);
+	if(solved){
+		print_move_solution(start, goal, result->explored, result->explored, result);
+	} else {
+		printf("\n----------SOLUTION NOT FOUND----------\n");
+	}
+	printf("TRANSPOSITION TABLE PRUNED %ld STATES, MOVE FSM HAS %d NODES\n", tt_pruned, fsm_nodes);
+	free(result);
+	return solved ? 0 : -1;
+}
+
+/* Compares the states of two PackedNodes for qsort */
+int compare_states(const void* a, const void* b){
+	uint64_t x = ((const PackedNode*)a)->state;
+	uint64_t y = ((const PackedNode*)b)->state;
+	return (x > y) - (x < y);
+}
+
+/* Explores up to options.batch open nodes at once for --batch (one
+ * iteration of a_star_search()).  The best valid nodes are popped and
+ * closed first, then all their children are generated and scored in one
+ * flat pass over 'children' (4 slots per node, state 0 for impossible
+ * moves), spread over the OpenMP threads when built with -fopenmp.  The
+ * children are sorted by state so copies of a board reached from several
+ * nodes of the batch are merged in one pass, keeping the lowest g, before
+ * they go into the table and the open list.  Nodes another proc has
+ * explored are skipped if 'closed' is not NULL.  'batch' and 'children' hold
+ * options.batch and 4*options.batch nodes.  Returns 1 if a goal was explored */
+int expand_batch(NodeTable* table, BucketQueue* open_list, Histogram* f_hist, Incumbent* incumbent, DistClosed* closed, PackedNode* batch, PackedNode* children, uint64_t goal_state, int weight, int* found_cost, long* explored, int rank, int nprocs){
+	int count = 0;                           // number of nodes in the batch
+	int solved = 0;
+	PackedNode current;
+	while(count < options.batch && queue_pop(open_list, &current) != -1){
+		histogram_remove(f_hist, current.g + current.h);
+		PackedNode* entry = table_find(table, current.state);
+		if(entry == NULL || (entry->move & MOVE_CLOSED) || entry->g < current.g) continue; // stale copy, or shed
+		if(options.optimal && current.g + current.h >= incumbent->cost) continue; // cannot lead to a better solution
+		if(closed != NULL && !closed_claim(closed, current.state, current.g)) continue; // another proc explored it
+		entry->move |= MOVE_CLOSED;          // move node to the closed set
+		note_change(entry->state);
+		(*explored)++;
+		if(current.state == goal_state){
+			if(current.g < *found_cost) *found_cost = current.g;
+			if(options.optimal) incumbent_publish(incumbent, current.g, rank, nprocs);
+			solved = 1;
+		} else {
+			batch[count++] = current;
+		}
+	}
+
+	int slots = count * 4;
+	int cutoff = options.optimal ? incumbent->cost : INT_MAX;
+	#pragma omp parallel for schedule(static) if(slots >= 256)
+	for(int i = 0; i < slots; i++){          // generate and score every child of the batch
+		PackedNode* parent = &batch[i / 4];
+		int move = i % 4;
+		int blank = node_blank(parent);
+		children[i].state = 0;
+		if(!move_possible(blank, move)) continue;
+		uint64_t state = packed_move(parent->state, blank, move);
+		int h = child_heuristic(parent->state, parent->h, blank, move, state);
+		if(parent->g + 1 + h >= cutoff) continue; // prune, f is too high
+		children[i] = make_packed_node(state, parent->g + 1, h, move, blank + move_delta[move]);
+	}
+
+	qsort(children, slots, sizeof(PackedNode), compare_states);
+	for(int i = 0; i < slots && i < PREFETCH_DISTANCE; i++){
+		if(children[i].state != 0) table_prefetch(table, children[i].state);
+	}
+	for(int i = 0; i < slots; i++){          // merge the copies of each state and add the best one
+		if(i + PREFETCH_DISTANCE < slots && children[i + PREFETCH_DISTANCE].state != 0){
+			table_prefetch(table, children[i + PREFETCH_DISTANCE].state); // probe ahead of the insertions
+		}
+		if(children[i].state == 0) continue;
+		PackedNode child = children[i];
+		while(i + 1 < slots && children[i + 1].state == child.state){
+			i++;
+			if(children[i].g < child.g) child = children[i];
+		}
+		if(!add_open_node(table, open_list, f_hist, child, weight)) continue;
+		if(child.state == goal_state && options.optimal){ // publish the new incumbent right away
+			if(child.g < *found_cost) *found_cost = child.g;
+			incumbent_publish(incumbent, child.g, rank, nprocs);
+		}
+	}
+	return solved;
+}
+
+/* Explores 'node', a child whose key is within la->bound, right away
+ * instead of pushing it to the open list (A* with lookahead).  Unless its
+ * state was already reached with a g at least as low, it goes into the
+ * table as closed and its children are handled the same way while their
+ * key stays within the bound and fewer than 'depth' probe moves were made;
+ * the children past the bound or the depth, the frontier of the probe, are
+ * added to the open list.  With a consistent heuristic the open list would
+ * give out these nodes next anyway, so the probe keeps A*'s order up to
+ * ties.  Returns 1 if the goal was explored */
+int lookahead_probe(Lookahead* la, PackedNode node, int depth){
+	PackedNode* found = table_find(la->table, node.state);
+	if(found != NULL && found->g <= node.g) return 0; // reached with a g at least as low
+	if(found == NULL){
+		found = table_insert(la->table, node);
+		if(found == NULL){                   // no room left, dropped like a shed node
+			if(node.g + node.h < shed_f) shed_f = node.g + node.h;
+			return 0;
+		}
+	} else {
+		*found = node;                       // the copy in the open list is skipped when it is removed
+		note_change(node.state);
+	}
+	if(la->closed != NULL && !closed_claim(la->closed, node.state, node.g)) return 0; // another proc explored it
+	found->move |= MOVE_CLOSED;
+	note_change(node.state);
+	(*la->explored)++;
+	la->probed++;
+	if(node.state == la->goal_state){
+		if(node.g < *la->found_cost) *la->found_cost = node.g;
+		if(options.optimal) incumbent_publish(la->incumbent, node.g, rank, nprocs);
+		return 1;
+	}
+	int solved = 0;
+	int blank = node_blank(&node);
+	for(int move = 0; move < 4; move++){
+		if(!move_possible(blank, move)) continue;
+		uint64_t state = packed_move(node.state, blank, move);
+		int h = child_heuristic(node.state, node.h, blank, move, state);
+		if(options.optimal && node.g + 1 + h >= la->incumbent->cost) continue; // prune, f is too high
+		PackedNode child = make_packed_node(state, node.g + 1, h, move, blank + move_delta[move]);
+		if(depth > 1 && node_key(&child, la->weight) <= la->bound){
+			if(lookahead_probe(la, child, depth - 1)) solved = 1;
+		} else if(add_open_node(la->table, la->open_list, la->f_hist, child, la->weight) && state == la->goal_state && options.optimal){
+			if(child.g < *la->found_cost) *la->found_cost = child.g;
+			incumbent_publish(la->incumbent, child.g, rank, nprocs);
+		}
+	}
+	return solved;
+}
+
+/* Informed search algorithm that finds a path or solution
+ * from the start board to the goal board. The heuristic function 
+ * used is the Manhattan Distance, which is updated incrementally
+ * for each child from manhattan_table.  Boards are stored as 16 byte
+ * PackedNodes in a NodeTable (every generated board) and a BucketQueue
+ * (boards yet to be explored) ordered by node_key(): h by default, or
+ * g + w*h with --weight w, which finds a solution no longer than w times
+ * the optimal one (w = 1 is plain A*).  The solution sequence is rebuilt
+ * by undoing the stored moves.
+ *
+ * All procs explore the same boards until the open list is big enough to
+ * give each proc at least 2 boards, then split_open_list() divides it and
+ * each proc searches from its own boards.  After that a proc running low
+ * on boards asks a random proc for some of its best ones (see
+ * steal_request()), so no proc sits idle while others have work.  The procs
+ * compare their results with MPI_Allreduce every options.sync_interval
+ * iterations, and only stop once no stolen boards are on their way.  By default the
+ * search stops at the first solution any proc finds.  With --optimal, the
+ * cost of the best solution (the incumbent) is sent to the other procs as
+ * soon as it is found, each proc drops boards whose f is at least the
+ * incumbent, and the search only stops once the lowest f of any open board
+ * on any proc reaches the incumbent, which proves the solution is optimal.
+ * With --lookahead k, a child whose key is no higher than its parent's is
+ * explored at once by a probe up to k moves deep (lookahead_probe()), and
+ * only the probe's frontier goes into the open list.
+ * With --checkpoint, every proc saves the nodes of its part of the search
+ * that changed in the last options.checkpoint_every iterations
+ * (checkpoint_save()), and --restart resumes from the last checkpoint,
+ * even with a different number of procs.
+ * Return 0 if a solution was found and -1 otherwise.  Algorithm is
+ * described further in the README file */
+int a_star_search(Board* start, Board* goal, int rank, int nprocs){
+	int solution_found = 0;                 // set to 0 meaning no solution has been found, updated to 1 when a solution is found
+	long iters = 1;                         // holds count of loop iterations
+	long explored = 0;                      // number of states moved to the closed set
+	int found_cost = INT_MAX;               // cost of the best goal in this proc's table
+	int status[6];                          // this proc's {lowest open f, best solution cost, -solution_found, -has work, -memory low, lowest shed f}
+	int checker[6];                         // status combined over all procs with MPI_Allreduce (MPI_MIN)
+	int split = nprocs == 1;                // 1 once the open list has been divided between the procs
+	DistClosed* closed = options.closed_entries > 0 && nprocs > 1 ? make_closed(options.closed_entries, nprocs) : NULL; // used once split
+	int weight = scale_weight(options.weight);
+	uint64_t start_state = pack_board(start);
+	uint64_t goal_state = pack_board(goal);
+	NodeTable* table = make_table(initial_table_capacity()); // every state generated so far, open and closed
+	BucketQueue* open_list = make_queue(key_priorities(weight)); // states that have yet to be explored
+	Histogram f_hist;                       // f values of the nodes in open_list
+	Incumbent* incumbent = make_incumbent(nprocs);
+	Stealer* stealer = make_stealer(rank, nprocs);
+	int global_min_f = 0;                   // lowest open f over all procs at the last check
+	PackedNode* batch = NULL;               // with --batch, the nodes explored in one iteration
+	PackedNode* children = NULL;            // with --batch, their children
+	if(options.batch > 1){
+		batch = malloc(options.batch * sizeof(PackedNode));
+		children = malloc(options.batch * 4 * sizeof(PackedNode));
+		assert(batch && children);
+	}
+	long next_checkpoint = options.checkpoint_every; // iteration of the next checkpoint
+	Lookahead probe = { table, open_list, &f_hist, incumbent, NULL, goal_state, weight, 0, &found_cost, &explored, 0 }; // with --lookahead
+	init_histogram(&f_hist);
+	shed_f = INT_MAX;
+
+	if(start_state == goal_state){ // check if given node is equal to goal
+		printf("---SOLUTION FOUND---\n");
+		printf("initial board was equal to the goal board\n");
+		destroy_table(table);
+		destroy_queue(open_list);
+		free(batch);
+		free(children);
+		if(closed != NULL) destroy_closed(closed);
+		incumbent_finish(incumbent, rank, nprocs);
+		steal_finish(stealer, rank, nprocs);
+		return 0;
+	}
+
+	CheckpointHeader resumed;
+	CheckpointManifest manifest;             // the set of checkpoint files found, replaced by this run's
+	int restarted = options.restart && checkpoint_load(table, open_list, &f_hist, weight, &resumed, &manifest, start_state, goal_state, rank, nprocs) == 0;
+	if(restarted){
+		iters = resumed.iters;
+		explored = resumed.explored;
+		found_cost = resumed.found_cost;
+		shed_f = resumed.shed_f;
+		incumbent->cost = resumed.incumbent;
+		split = resumed.split || nprocs == 1;
+		next_checkpoint = iters + options.checkpoint_every;
+		if(rank == 0) printf("resumed from checkpoint %s at iteration %ld\n", options.checkpoint, iters);
+	} else {
+		if(options.restart && rank == 0) printf("no usable checkpoint %s, starting over\n", options.checkpoint);
+		PackedNode first = make_packed_node(start_state, 0, heuristic(start_state), MOVE_ROOT, packed_blank(start_state));
+		table_insert(table, first);
+		queue_push(open_list, node_key(&first, weight), first); // add initial board to open list
+		histogram_add(&f_hist, first.h);
+	}
+	Checkpointer* checkpointer = NULL;       // with --checkpoint
+	if(options.checkpoint != NULL && restarted){
+		checkpointer = make_checkpointer(resumed.generation + 1, &manifest);
+	} else if(options.checkpoint != NULL){   // a new set named after any old one, which is kept until it is replaced
+		int old = rank == 0 && manifest_read(&manifest) == 0;
+		MPI_Bcast(&old, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		MPI_Bcast(&manifest, sizeof(manifest), MPI_BYTE, 0, MPI_COMM_WORLD);
+		checkpointer = make_checkpointer(old ? manifest.base + 1 : 1, old ? &manifest : NULL);
+	}
+
+	while(1){
+		PackedNode current;
+		PackedNode* entry = NULL;           // the table slot of 'current', NULL if there is nothing to explore
+
+		if(options.optimal) incumbent_poll(incumbent);
+		if(options.batch > 1){
+			if(expand_batch(table, open_list, &f_hist, incumbent, split ? closed : NULL, batch, children, goal_state, weight, &found_cost, &explored, rank, nprocs)) solution_found = 1;
+		}
+		while(options.batch == 1 && entry == NULL && queue_pop(open_list, &current) != -1){
+			histogram_remove(&f_hist, current.g + current.h);
+			entry = table_find(table, current.state);
+			if(entry == NULL || (entry->move & MOVE_CLOSED) || entry->g < current.g){
+				entry = NULL; // stale copy, the state was explored, shed or reached with a lower g since it was pushed
+			} else if(options.optimal && current.g + current.h >= incumbent->cost){
+				entry = NULL; // cannot lead to a better solution
+			} else if(split && closed != NULL && !closed_claim(closed, current.state, current.g)){
+				entry = NULL; // another proc explored it
+			}
+		}
+
+		if(entry != NULL){
+			entry->move |= MOVE_CLOSED;     // move node to the closed set
+			note_change(entry->state);
+			explored++;
+			if(current.state == goal_state){ // found a solution, the search stops at the next check
+				if(current.g < found_cost) found_cost = current.g;
+				if(options.optimal) incumbent_publish(incumbent, current.g, rank, nprocs);
+				solution_found = 1;
+			} else {
+				int blank = node_blank(&current);
+				int hs[4];                       // with --partial, h of each child, -1 if the move is not possible
+				int low = -1, high = INT_MAX;    // priorities of the children generated by this expansion (low is excluded)
+				uint64_t states[4];              // state of each child to generate, 0 if it is skipped
+				int next = partial_bounds(&current, blank, weight, hs, &low, &high);
+				for(int move = 0; move < 4; move++){ // make every child first and prefetch its table slot
+					states[move] = 0;
+					if(!move_possible(blank, move)) continue;
+					if(options.partial){
+						int key = key_of(current.g + 1, hs[move], weight);
+						if(key <= low || key > high) continue; // generated by an earlier or a later expansion
+					}
+					states[move] = packed_move(current.state, blank, move);
+					table_prefetch(table, states[move]);
+				}
+				for(int move = 0; move < 4; move++){ // then score the children and probe the table for them
+					uint64_t state = states[move];
+					if(state == 0) continue;
+					int h = options.partial ? hs[move] : child_heuristic(current.state, current.h, blank, move, state);
+					if(options.optimal && current.g + 1 + h >= incumbent->cost) continue; // prune, f is too high
+					PackedNode child = make_packed_node(state, current.g + 1, h, move, blank + move_delta[move]);
+					if(options.lookahead > 0 && node_key(&child, weight) <= node_key(&current, weight)){
+						probe.closed = split ? closed : NULL;
+						probe.bound = node_key(&current, weight);
+						if(lookahead_probe(&probe, child, options.lookahead)) solution_found = 1;
+						continue;
+					}
+					if(!add_open_node(table, open_list, &f_hist, child, weight)) continue;
+					if(state == goal_state && options.optimal){ // publish the new incumbent right away
+						if(child.g < found_cost) found_cost = child.g;
+						incumbent_publish(incumbent, child.g, rank, nprocs);
+					}
+				}
+				if(next != INT_MAX){             // some children are left, expand the node again at priority 'next'
+					entry = table_find(table, current.state); // adding children may have grown the table
+					entry->move &= ~MOVE_CLOSED;
+					note_change(entry->state);
+					current.key_offset = next - node_key(&current, weight);
+					queue_push(open_list, next, current);
+					histogram_add(&f_hist, current.g + current.h);
+				}
+			}
+		}
+
+		if(!split && open_list->size >= (size_t)nprocs*2){ // every proc gets here at the same iteration
+			split_open_list(open_list, table, &f_hist, rank, nprocs);
+			split = 1;
+		}
+
+		if(split && options.steal_low > 0){ // share work with the procs running low
+			steal_poll(stealer, table, open_list, &f_hist, weight);
+			steal_request(stealer, open_list, &f_hist, global_min_f, rank, nprocs);
+		}
+
+		if(iters % options.sync_interval == 0 || !split){
+			// checks if solution was found by any proc, and if any proc still has boards to explore
+			if(memory_low) shed_open_nodes(table, open_list, &f_hist); // leaves memory_low set if that is not enough
+			status[0] = f_hist.min == HIST_VALUES ? INT_MAX : f_hist.min;
+			status[1] = options.optimal ? incumbent->cost : found_cost;
+			status[2] = -solution_found;
+			status[3] = -(open_list->size != 0);
+			status[4] = -memory_low;
+			status[5] = shed_f;
+			MPI_Allreduce(status, checker, 6, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+			int best = checker[1];
+			int bound = checker[0] < checker[5] ? checker[0] : checker[5]; // lowest f of any open or shed board
+			int done, lost;                  // lost: only the shed boards are left to search
+			global_min_f = checker[0];
+			if(options.optimal){
+				incumbent->cost = best;
+				done = bound >= best;        // no open or shed board on any proc can beat the incumbent
+				lost = !done && checker[0] > checker[5];
+			} else {
+				done = checker[2] < 0 || (checker[3] == 0 && checker[5] == INT_MAX);
+				lost = !done && checker[3] == 0;
+			}
+			if(done) done = steal_settled(stealer, nprocs); // stolen boards still on their way may be better or be the only work left
+			if(!done && (checker[4] < 0 || lost) && steal_settled(stealer, nprocs)){ // a proc is out of memory, or shed boards are needed
+				incumbent_finish(incumbent, rank, nprocs);
+				steal_finish(stealer, rank, nprocs);
+				destroy_table(table);
+				destroy_queue(open_list);
+				free(batch);
+				free(children);
+				if(closed != NULL) destroy_closed(closed);
+				if(checkpointer != NULL) checkpoint_finish(checkpointer);
+				return memory_fallback(start, goal, bound, iters, explored, rank);
+			}
+			if(!done && checkpointer != NULL && iters >= next_checkpoint){ // every proc has the same iters
+				CheckpointHeader header = { 0 };
+				header.start_state = start_state;
+				header.goal_state = goal_state;
+				header.iters = iters;
+				header.explored = explored;
+				header.split = split;
+				header.found_cost = found_cost;
+				header.incumbent = best;
+				header.shed_f = shed_f;
+				if(checkpoint_save(table, &header, stealer, checkpointer, rank, nprocs)){
+					next_checkpoint = iters + options.checkpoint_every;
+				}
+			}
+			if(done){ // exit the function bc a solution was found or every open list is empty
+				int winner = nprocs;         // lowest rank holding a best solution, the path is traced from it
+				int mine = (best != INT_MAX && found_cost == best) ? rank : nprocs;
+				long total_explored = 0;
+				incumbent_finish(incumbent, rank, nprocs); // drain the other messages, trace_distributed_path() takes any tag
+				steal_finish(stealer, rank, nprocs);
+				MPI_Allreduce(&mine, &winner, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+				MPI_Reduce(&explored, &total_explored, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+				if(closed != NULL){
+					long skipped = 0;
+					MPI_Reduce(&closed->skipped, &skipped, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+					if(rank == 0) printf("SKIPPED %ld STATES ALREADY EXPLORED BY ANOTHER PROC\n", skipped);
+					destroy_closed(closed);
+				}
+				if(options.lookahead > 0){
+					long probed = 0;
+					MPI_Reduce(&probe.probed, &probed, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+					if(rank == 0) printf("EXPLORED %ld STATES IN LOOKAHEAD PROBES, WITHOUT THE OPEN LIST\n", probed);
+				}
+				if(winner != nprocs){
+					uint64_t* path;
+					int steps = trace_distributed_path(table, goal_state, winner, rank, nprocs, &path);
+					if(rank == 0){           // proc 0 prints the sequence
+						print_solution(start, goal, iters, total_explored, path, steps);
+						printf("SOLUTION FOUND BY PROC %d\n", winner);
+						if(options.optimal) printf("SOLUTION IS OPTIMAL\n");
+						free(path);
+					}
+				}
+				destroy_table(table);
+				destroy_queue(open_list);
+				free(batch);
+				free(children);
+				if(checkpointer != NULL) checkpoint_finish(checkpointer);
+				return best != INT_MAX ? 0 : -1;
+			}
+		}
+		iters++;
+	} // while
+}
 
-typedef struct Action          // struct to define a possible action that can be performed on a Board
-{
-	char* direction;           // the direction in which a board 'tile' can be shifted, possible
-			                   // values can be "up", "down", "left", or "right"
-	int row;                   // target row to move the tile
-	int col;                   // target column to move the tile
-	int value;                 // value of the tile to be moved
-} Action;                      // an Action is when you swap a numbered tile with the 0 tile
-
-typedef struct Node            // Nodes that will be in the linkedlist
-{
-	Board* board;              // Board struct
-	struct Node* next;         // next node in the list
-} Node;
+/* Writes the name of a bucket file into 'path'.  'kind' is "new" for the
+ * unsorted nodes generated into bucket (g, h), "run" for sorted runs made
+ * from them, and "srt" for the sorted bucket with duplicates removed */
+void bucket_path(char* path, char* kind, int g, int h, int run){
+	snprintf(path, 512, "%s/astar%d_%s_g%d_h%d_%d.bin", options.disk_dir, rank, kind, g, h, run);
+}
 
-typedef struct LinkedList      // LinkedList to hold a list of Boards
-{
-	int size;                  // size of the list
-	Node* head;                // pointer to the first element in the list
-	Node* tail;                // pointer to the last element in the list
-} LinkedList;
+/* Sorts the unsorted file of bucket (g, h) with an external merge sort and
+ * removes duplicates, both within the bucket and any state already in the
+ * sorted buckets (g-1, h) or (g-2, h), which are the only earlier buckets a
+ * duplicate with the same h can be in.  Every file is read and written
+ * sequentially.  Writes the result to the "srt" file of the bucket, deletes
+ * the unsorted file, and returns the number of nodes left, or -1 if a file
+ * could not be read or written */
+long disk_sort_bucket(int g, int h){
+	char path[512];
+	size_t chunk = options.disk_buffer;
+	PackedNode* nodes = malloc(chunk * sizeof(PackedNode));
+	assert(nodes);
+	int failed = 0;
 
+	// make sorted runs of at most 'chunk' nodes
+	int runs = 0;
+	bucket_path(path, "new", g, h, 0);
+	DiskStream* in = disk_open(path, 0, chunk);
+	size_t count = in != NULL;
+	while(count != 0 && !failed){
+		count = 0;
+		while(count < chunk && disk_get(in, &nodes[count])) count++;
+		if(count == 0) break;
+		qsort(nodes, count, sizeof(PackedNode), compare_states);
+		bucket_path(path, "run", g, h, runs++);
+		remove(path);                        // disk_open() appends
+		DiskStream* out = disk_open(path, 1, chunk);
+		if(out == NULL){
+			failed = 1;
+			break;
+		}
+		for(size_t i = 0; i < count; i++) disk_put(out, nodes[i]);
+		if(disk_close(out) != 0) failed = 1;
+	}
+	if(in == NULL || disk_close(in) != 0) failed = 1;
+	free(nodes);
+	bucket_path(path, "new", g, h, 0);
+	remove(path);
 
-/* Allocate memory for a Board struct.  Set the values all to the default which is
- * 0 for the heuristic value, NULL for the parent, and 0's for all values in the 
- * 2d array.  Return a pointer to the resulting Board. */
-Board* make_empty_board(){
-	Board* brd = (Board*)malloc(sizeof(Board));
-	assert(brd);
-	for(int i = 0; i < ROWS; i++){
-		for(int j = 0; j < COLS; j++){
-			brd->board[i][j] = 0;
+	// merge the runs and drop duplicates and states in the previous layers
+	int sources = runs + 2;
+	DiskStream** streams = malloc(sources * sizeof(DiskStream*));
+	PackedNode* heads = malloc(sources * sizeof(PackedNode));
+	int* valid = malloc(sources * sizeof(int));
+	assert(streams && heads && valid);
+	size_t capacity = chunk / sources > 1024 ? chunk / sources : 1024;
+	for(int i = 0; i < sources; i++){
+		if(i < runs){
+			bucket_path(path, "run", g, h, i);
+		} else {
+			bucket_path(path, "srt", g - (i - runs) - 1, h, 0); // layers g-1 and g-2
+		}
+		streams[i] = (i < runs || g - (i - runs) - 1 >= 0) ? disk_open(path, 0, capacity) : NULL;
+		valid[i] = streams[i] != NULL && disk_get(streams[i], &heads[i]);
+	}
+	bucket_path(path, "srt", g, h, 0);
+	remove(path);
+	DiskStream* out = failed ? NULL : disk_open(path, 1, chunk);
+	if(out == NULL) failed = 1;
+	long kept = 0;
+	while(!failed){
+		int min = -1;
+		for(int i = 0; i < runs; i++){
+			if(valid[i] && (min == -1 || heads[i].state < heads[min].state)) min = i;
+		}
+		if(min == -1) break;
+		PackedNode node = heads[min];
+		for(int i = 0; i < runs; i++){ // skip every copy of the state in the runs
+			while(valid[i] && heads[i].state == node.state){
+				valid[i] = disk_get(streams[i], &heads[i]);
+			}
+		}
+		int duplicate = 0;
+		for(int i = runs; i < sources; i++){ // advance the previous layers up to the state
+			while(valid[i] && heads[i].state < node.state){
+				valid[i] = disk_get(streams[i], &heads[i]);
+			}
+			if(valid[i] && heads[i].state == node.state) duplicate = 1;
+		}
+		if(!duplicate){
+			disk_put(out, node);
+			kept++;
 		}
 	}
-	brd->h_score = 0;
-	brd->parent = NULL;
-	return brd;
+	if(out != NULL && disk_close(out) != 0) failed = 1;
+	for(int i = 0; i < sources; i++){
+		if(streams[i] != NULL && disk_close(streams[i]) != 0) failed = 1;
+		if(i < runs){
+			bucket_path(path, "run", g, h, i);
+			remove(path);
+		}
+	}
+	free(streams);
+	free(heads);
+	free(valid);
+	return failed ? -1 : kept;
 }
 
-/* free the allocated Board struct */
-void destroy_board(Board* brd){ 
-	free(brd);
+/* Deletes the "new" and "srt" files of every bucket with a g up to max_g */
+void disk_remove_buckets(int max_g){
+	char path[512];
+	for(int g = 0; g <= max_g; g++){
+		for(int h = 0; h < DISK_MAX_H; h++){
+			bucket_path(path, "new", g, h, 0);
+			remove(path);
+			bucket_path(path, "srt", g, h, 0);
+			remove(path);
+		}
+	}
 }
 
-/* print h_score and 2d array of a Board struct */
-void print_board(Board* brd){    
-	printf("H = %d,  ", brd->h_score);
-	printf("Board:\n");
-	for(int i = 0; i < ROWS; i++){
-		for(int j = 0; j < COLS; j++){
-			printf("%-4d", brd->board[i][j]); // prints values left-justified
+/* Finds the node with the given state in the sorted file of bucket (g, h)
+ * with a binary search.  Returns 1 and sets 'node' if it was found */
+int disk_lookup(int g, int h, uint64_t state, PackedNode* node){
+	char path[512];
+	bucket_path(path, "srt", g, h, 0);
+	FILE* file = fopen(path, "rb");
+	if(file == NULL) return 0;
+	fseek(file, 0, SEEK_END);
+	long low = 0;
+	long high = ftell(file) / (long)sizeof(PackedNode) - 1;
+	int found = 0;
+	while(low <= high && !found){
+		long mid = (low + high) / 2;
+		fseek(file, mid * (long)sizeof(PackedNode), SEEK_SET);
+		size_t read = fread(node, sizeof(PackedNode), 1, file);
+		assert(read == 1);
+		if(node->state == state){
+			found = 1;
+		} else if(node->state < state){
+			low = mid + 1;
+		} else {
+			high = mid - 1;
 		}
-		printf("\n");
 	}
+	fclose(file);
+	return found;
 }
 
-/* Returns 0 if the 2d arrays are equal and -1 otherwise */
-int compare_boards(int x[ROWS][COLS], int y[ROWS][COLS]){
-	for(int i = 0; i < ROWS; i++){
-		for(int j = 0; j < COLS; j++){
-			if(x[i][j] != y[i][j]){
-				return -1;
+/* A* search that keeps the open and closed sets in files under options.disk_dir
+ * instead of memory (external-memory A*).  Nodes are kept in buckets by
+ * (g, h) and the buckets are expanded in order of f = g + h, then g, which
+ * is A* order, so the first goal found is on an optimal path.  A bucket's
+ * duplicates are removed all at once by disk_sort_bucket() just before the
+ * bucket is expanded (delayed duplicate detection), so no lookups are done
+ * per node.  The solution sequence is rebuilt by undoing the stored moves
+ * and finding each parent in the sorted bucket it was expanded from.
+ * Bucket files left in the directory by an earlier run are deleted first.
+ * Returns 0 if a solution was found and -1 otherwise, also when a bucket
+ * file could not be read or written */
+int disk_a_star_search(Board* start, Board* goal){
+	char path[512];
+	long iters = 0;                          // number of buckets expanded
+	long explored = 0;                       // number of states expanded
+	uint64_t start_state = pack_board(start);
+	uint64_t goal_state = pack_board(goal);
+	int start_h = packed_manhattan(start_state);
+	size_t (*counts)[DISK_MAX_H] = calloc(DISK_MAX_G, sizeof(*counts)); // nodes written to each unsorted bucket
+	assert(counts);
+	int max_g = 0;                           // deepest layer a bucket file was made for
+	PackedNode found;                        // the goal node once it is found
+	int solved = 0;
+	int failed = 0;                          // 1 once a bucket file could not be read or written
+
+	disk_remove_buckets(DISK_MAX_G - 1);     // they would be read back as nodes of this search
+	bucket_path(path, "new", 0, start_h, 0);
+	DiskStream* out = disk_open(path, 1, 1);
+	if(out != NULL){
+		disk_put(out, make_packed_node(start_state, 0, start_h, MOVE_ROOT, packed_blank(start_state)));
+	}
+	failed = out == NULL || disk_close(out) != 0;
+	counts[0][start_h] = 1;
+
+	for(int f = start_h; f < DISK_MAX_G + DISK_MAX_H && !solved && !failed; f++){
+		int remaining = 0;                   // 1 if a bucket with at least this f is not expanded
+		for(int g = 0; g < DISK_MAX_G; g++){
+			for(int h = 0; h < DISK_MAX_H; h++){
+				if(counts[g][h] != 0 && g + h >= f) remaining = 1;
+			}
+		}
+		if(!remaining) break;
+
+		for(int g = 0; g <= f && g < DISK_MAX_G - 1 && !solved && !failed; g++){
+			int h = f - g;
+			if(h >= DISK_MAX_H || counts[g][h] == 0) continue;
+			counts[g][h] = 0;
+			long kept = disk_sort_bucket(g, h);
+			if(kept < 0) failed = 1;
+			if(kept <= 0) continue;
+			iters++;
+
+			bucket_path(path, "srt", g, h, 0);
+			DiskStream* in = disk_open(path, 0, options.disk_buffer);
+			DiskStream* children[2];         // children with h - 1 and h + 1
+			for(int d = 0; d < 2; d++){
+				int child_h = h - 1 + 2 * d;
+				children[d] = NULL;
+				if(child_h >= 0 && child_h < DISK_MAX_H){
+					bucket_path(path, "new", g + 1, child_h, 0);
+					children[d] = disk_open(path, 1, options.disk_buffer);
+					if(children[d] == NULL) failed = 1;
+					max_g = g + 1;
+				}
+			}
+			PackedNode node;
+			while(!failed && in != NULL && disk_get(in, &node)){
+				explored++;
+				if(node.state == goal_state){
+					found = node;
+					solved = 1;
+					break;
+				}
+				int blank = node_blank(&node);
+				for(int move = 0; move < 4; move++){
+					if(!move_possible(blank, move)) continue;
+					if(!(node.move & MOVE_ROOT) && move == ((node.move & MOVE_MASK) ^ 1)) continue; // would undo the parent's move
+					int delta = packed_manhattan_delta(node.state, blank, move);
+					int d = delta > 0;
+					if(children[d] == NULL) continue;
+					uint64_t state = packed_move(node.state, blank, move);
+					disk_put(children[d], make_packed_node(state, g + 1, h + delta, move, blank + move_delta[move]));
+					counts[g + 1][h + delta]++;
+				}
+			}
+			if(in == NULL || disk_close(in) != 0) failed = 1;
+			for(int d = 0; d < 2; d++){
+				if(children[d] != NULL && disk_close(children[d]) != 0) failed = 1;
 			}
 		}
 	}
-	return 0;
-}
 
-/* Copies all values from Board A to Board B */
-void copy_board(Board* a, Board* b){
-	for(int i = 0; i < ROWS; i++){
-		for(int j = 0; j < COLS; j++){
-			b->board[i][j] = a->board[i][j];
+	if(failed){
+		printf("could not read or write the bucket files under %s, stopping the search\n", options.disk_dir);
+		solved = 0;
+	} else if(solved){
+		uint64_t* path_states = malloc((found.g + 1) * sizeof(uint64_t));
+		assert(path_states);
+		int steps = 0;
+		PackedNode node = found;
+		while(!(node.move & MOVE_ROOT)){     // walk back through the sorted buckets
+			path_states[steps++] = node.state;
+			int move = node.move & MOVE_MASK;
+			uint64_t parent = packed_move(node.state, node_blank(&node), move ^ 1);
+			int found_parent = disk_lookup(node.g - 1, packed_manhattan(parent), parent, &node);
+			assert(found_parent);
 		}
+		print_solution(start, goal, iters, explored, path_states, steps);
+		free(path_states);
+	} else {
+		printf("\n----------SOLUTION NOT FOUND----------\n");
 	}
-	b->h_score = a->h_score;
-	b->parent = a->parent;
-}
 
+	disk_remove_buckets(max_g);
+	free(counts);
+	return solved ? 0 : -1;
+}
 
-/* Create and return an Action struct with the given values */
-Action make_action(char* direction, int row, int col, int value){
-	Action a;
-	a.direction = direction;
-	a.row = row;
-	a.col = col;
-	a.value = value;
-	return a;
+/* Calculates the Manhattan Distance of a packed state with the given table */
+int table_manhattan(uint64_t state, int table[TILES][TILES]){
+	int sum = 0;
+	for(int index = 0; index < TILES; index++){
+		sum += table[packed_tile(state, index)][index];
+	}
+	return sum;
 }
 
-/* Print all values of an Action in a readable manner */
-void print_action(Action act){
-	printf("Move %d in Row: %d  Column: %d %s\n", act.value, act.row, act.col, act.direction);
+/* Add the given node to the end of the FrontierLayer, doubling the array if it is full */
+void layer_push(FrontierLayer* layer, FrontierNode node){
+	if(layer->size == layer->capacity){
+		layer->capacity = layer->capacity == 0 ? (size_t)initial_arr_size : layer->capacity * 2;
+		layer->nodes = realloc(layer->nodes, layer->capacity * sizeof(FrontierNode));
+		assert(layer->nodes);
+	}
+	layer->nodes[layer->size++] = node;
 }
 
-/* Creates and allocates space for a single node with given board.
- * Set next value to NULL initially */
-Node* make_node(Board* brd){
-	Node* result = malloc(sizeof(Node));
-	assert(result);
-	result->board = brd;
-	result->next = NULL;
-	return result;
+/* Compares the states of two FrontierNodes for qsort */
+int compare_frontier_nodes(const void* a, const void* b){
+	uint64_t x = ((const FrontierNode*)a)->state;
+	uint64_t y = ((const FrontierNode*)b)->state;
+	return (x > y) - (x < y);
 }
 
-/* Free memory allocated for the Node */
-void destroy_node(Node* node){
-	destroy_board(node->board);
-	free(node);
-}
-
-/* Allocates space for a linkedlist.  Sets the head and tail 
- * pointers to NULL and initial size to 0. */
-LinkedList* make_list(){
-	LinkedList* list = malloc(sizeof(LinkedList));
-	assert(list);
-	list->head = NULL;
-	list->tail = NULL;
-	list->size = 0;
-	return list;
-}
-
-/* Free memory allocated for the linkedlist */
-void free_list(LinkedList* list){
-	Node* tmp =  list->head;
-	while(tmp != list->tail){
-		Node* delete = tmp;
-		tmp = tmp->next;
-		destroy_node(delete);
-	}
-	free(list->tail);
-	free(list);
-}
-
-/* Prints a given list in an easily readable manner */
-void print_list(LinkedList* list){
-	Node* tmp = list->head;
-	while(tmp != list->tail){
-		Node* next = tmp;
-		print_board(tmp->board);
-		tmp = tmp->next;
-	}
-	print_board(list->tail->board);
-}
-
-/* Prints a node and all of its parents.  Used to print and visualize
- * the sequence taken to reach a solution in a_star_search */
- void print_parents(Node* node){
- 	int steps = 0; // keep track of how many moves it took to solve (equal to number of parents
- 	printf("\n----- SOLUTION SEQUENCE -----\n");
- 	while(node->board->parent != NULL){
- 		printf("\n");
- 		print_board(node->board);
- 		node->board = node->board->parent;
- 		steps++;
- 	}
- 	printf("\n----- SOLUTION SEQUENCE -----\n");
- 	printf("\n----------------------------------\n");
- 	printf("\nNumber of moves to solution: %d\n", steps);
- 	printf("\n----------------------------------\n\n");
- }
-
-/* Add the given node to the end of the given linkedlist*/
-void push(LinkedList* ll, Node* node){
-	if(ll->size == 0){
-		ll->head = node;
-		ll->tail = node;
-		ll->size++;
-	}else if(ll->size == 1){
-		ll->head->next = node;
-		ll->tail = node;
-		ll->size++;
-	}else{
-		ll->tail->next = node;
-		ll->tail = node;
-		ll->size++;
-	}
-}
-
-/* Remove the first node in the given linkedlist */
-void pop(LinkedList* list){
-	if(list->size == 1){
-		destroy_node(list->head);
-		list->head = NULL;
-		list->tail = NULL;
-		list->size--;
-	}else if(list->size == 2){
-		destroy_node(list->head);
-		list->head = list->tail;
-		list->size--;
-	}else{
-		Node* tmp = list->head->next;
-		destroy_node(list->head);
-		list->head = tmp;
-		list->size--;
-	}
-}
-
-/* Delete the given node from the LinkedList and update pointers */
-void remove_node(LinkedList* list, Node* node){
-	if(list->size == 1){
-		list->head = NULL;
-		list->tail = NULL;
-		list->size--;
-	} else if(list->size == 2){
-		if(list->head == node){
-			list->head = list->tail;
-			list->size--;
-		} else {
-			list->tail = list->head;
-			list->size--;
-		}
-	} else {
-		if(list->head == node){
-			Node* tmp = list->head;
-			list->head = list->head->next;
-			list->size--;
-		} else if (list->tail == node){
-			Node* prev = list->head;
-			while(prev->next->next != NULL){ // find tails previous node 
-				prev = prev->next;
-			}
-			list->tail = prev;
-			list->size--;
+/* Sorts a layer and merges the copies of each state into one node, combining
+ * their used-operator bits so no copy's parent is generated again */
+void merge_layer(FrontierLayer* layer){
+	if(layer->size == 0) return;
+	qsort(layer->nodes, layer->size, sizeof(FrontierNode), compare_frontier_nodes);
+	size_t kept = 0;
+	for(size_t i = 1; i < layer->size; i++){
+		if(layer->nodes[i].state == layer->nodes[kept].state){
+			layer->nodes[kept].used |= layer->nodes[i].used;
 		} else {
-			Node* prev = list->head;
-			while(prev->next != node && prev->next != NULL){ // find previous node of node to be deleted
-				prev = prev->next;
-			}
-			prev->next = prev->next->next;
-			list->size--;
+			layer->nodes[++kept] = layer->nodes[i];
 		}
 	}
+	layer->size = kept + 1;
 }
 
-/* Stored the linkedlist in an array (NOT USED)) */
-Board** list_to_array(LinkedList* list){
-	Board** result = malloc(initial_arr_size * sizeof(Board*));
-	assert(result);
-	int index = 0;
-	Node* current = list->head;
+/* Breadth-first heuristic search from start to goal that prunes every node
+ * with f = g + h above 'bound'.  Only the layer being expanded and the next
+ * one are kept.  There is no closed list: a node's used-operator bits mark
+ * the moves that lead back to the nodes that generated it, and in the puzzle
+ * every neighbor of a node is in the layer before or after it, so duplicates
+ * are never generated.  Each node below 'relay_depth' remembers the state its
+ * path passes through at that depth, which is stored in 'relay' for the goal.
+ * Returns the depth of the goal, or -1 if it was not found within the bound */
+int bfhs(uint64_t start, uint64_t goal, int bound, int relay_depth, uint64_t* relay, long* explored){
+	int (*table)[TILES] = malloc(TILES * sizeof(*table)); // heuristic toward this search's goal
+	assert(table);
+	build_goal_table(goal, table);
+	FrontierLayer layers[2] = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+	FrontierLayer* current = &layers[0];
+	FrontierLayer* next = &layers[1];
+	int result = -1;
+
+	FrontierNode first = { start, relay_depth == 0 ? start : 0, table_manhattan(start, table), 0, packed_blank(start) };
+	if(first.h <= bound) layer_push(current, first);
 
-	while(current != NULL){
-		result[index] = current->board;
-		current = current->next;
-		index++;
+	for(int depth = 0; current->size != 0 && result == -1; depth++){
+		for(size_t i = 0; i < current->size; i++){
+			FrontierNode node = current->nodes[i];
+			if(node.state == goal){
+				*relay = node.relay;
+				result = depth;
+				break;
+			}
+			(*explored)++;
+			for(int move = 0; move < 4; move++){
+				if((node.used & (1 << move)) || !move_possible(node.blank, move)) continue;
+				int target = node.blank + move_delta[move];
+				int tile = packed_tile(node.state, target);
+				int h = node.h + table[tile][node.blank] - table[tile][target];
+				if(depth + 1 + h > bound) continue; // prune, f is above the bound
+				FrontierNode child;
+				child.state = packed_move(node.state, node.blank, move);
+				child.relay = depth + 1 == relay_depth ? child.state : node.relay;
+				child.h = h;
+				child.used = 1 << (move ^ 1); // the move back to this node
+				child.blank = target;
+				layer_push(next, child);
+			}
+		}
+		merge_layer(next);
+		FrontierLayer* tmp = current;         // the next layer becomes the current one,
+		current = next;                       // and the expanded layer is dropped
+		next = tmp;
+		next->size = 0;
 	}
+	free(layers[0].nodes);
+	free(layers[1].nodes);
+	free(table);
 	return result;
 }
 
-/* Double the size of the given array and return the new doubled array
- * (NOT USED) */
-Board** double_array(Board** old_array, int array_size){
-	Board** result = malloc((array_size*2) * sizeof(Board*));
-	assert(result);
-	//#pragma omp parallel for
-	for(int i = 0; i < array_size; i++){
-		result[i] = old_array[i];
+/* Stores the moves of an optimal path of the given length from start to goal
+ * in path[0] (one move after start) to path[depth-1] (goal).  The path is
+ * found by divide and conquer: a bounded bfhs() finds the state in the middle
+ * of the path, then the two halves are solved the same way */
+void frontier_path(uint64_t start, uint64_t goal, int depth, uint64_t* path, long* explored){
+	if(depth == 0) return;
+	if(depth == 1){
+		path[0] = goal;
+		return;
 	}
-	free(old_array);
-	return result;
+	int half = depth / 2;
+	uint64_t relay;
+	int found = bfhs(start, goal, depth, half, &relay, explored);
+	assert(found == depth);
+	frontier_path(start, relay, half, path, explored);
+	frontier_path(relay, goal, depth - half, path + half, explored);
 }
 
-/* Returns the node in the list with the minimum h_score value */
-Node* find_min_h(LinkedList* list){
-	int min = INT_MAX;
-	Node* tmp = list->head;
-	Node* result;
-	while(tmp != list->tail){
-		if(min > tmp->board->h_score){  // if h is smaller than current min, set new min
-			min = tmp->board->h_score;
-			result = tmp;
-		}
-		tmp = tmp->next;
-	}
-	if(min > list->tail->board->h_score){
-		min = list->tail->board->h_score;
-		result = list->tail;
+/* Breadth-first iterative deepening A* with frontier search.  Runs bfhs()
+ * with a bound starting at the start board's h and raised by 2 (a move
+ * changes f by 0 or 2) until the goal is found, so the solution is optimal.
+ * Memory scales with the width of the widest layer instead of the number of
+ * explored states.  The solution sequence is recovered with frontier_path()
+ * from the middle state of the last search.  Returns 0 if a solution was
+ * found and -1 otherwise */
+int frontier_search(Board* start, Board* goal){
+	long iters = 0;                          // number of bounds tried
+	long explored = 0;                       // number of states expanded, including path recovery
+	uint64_t start_state = pack_board(start);
+	uint64_t goal_state = pack_board(goal);
+	uint64_t relay = 0;
+	int depth = -1;
+	int bound;
+
+	if(start_state == goal_state){ // check if given node is equal to goal
+		printf("---SOLUTION FOUND---\n");
+		printf("initial board was equal to the goal board\n");
+		return 0;
 	}
-	return result;
-}
 
-/* Finds the minimum h value in the given list within the range
- * from start to stop.  Start and stop are the first and last values
- * for each process to explore */
-Node* find_min_h_parallel(LinkedList* list, int start, int stop){
-	int min = INT_MAX;
-	Node* result;
-	Node* first = list->head;
-	int count = 0;
-	while(first != NULL && count != start){ // set first to be the start node
-		first = first->next;
-		count++;
+	for(bound = packed_manhattan(start_state); bound < DISK_MAX_G && depth == -1; bound += 2){
+		depth = bfhs(start_state, goal_state, bound, bound / 2, &relay, &explored);
+		iters++;
 	}
-	while(first != NULL && count != stop){ // while the stop node hasnt been reached, search for lowest h_score
-		if(min > first->board->h_score){
-			min = first->board->h_score;
-			result = first;
-		}
-		first = first->next;
-		count++;
+	if(depth == -1){
+		printf("\n----------SOLUTION NOT FOUND----------\n");
+		return -1;
 	}
-	return result;
-}
 
-/* Returns 0 if the given node is in the list and -1 otherwise */
-int in_list(LinkedList* list, Node* node){
-	if(list->head == NULL) return -1; // there are no nodes in the list
-	Node* tmp = list->head;
-	while(tmp != list->tail){
-		if(compare_boards(tmp->board->board, node->board->board) == 0){ // if boards are equal, return node
-			return 0;
-		}
-		tmp = tmp->next;
+	int half = (bound - 2) / 2;              // relay depth of the search that found the goal
+	uint64_t* path = malloc(depth * sizeof(uint64_t));
+	assert(path);
+	frontier_path(start_state, relay, half, path, &explored);
+	frontier_path(relay, goal_state, depth - half, path + half, &explored);
+	for(int i = 0; i < depth / 2; i++){      // print_solution wants the goal first
+		uint64_t tmp = path[i];
+		path[i] = path[depth - 1 - i];
+		path[depth - 1 - i] = tmp;
 	}
-	if(compare_boards(list->tail->board->board, node->board->board) == 0){
+	print_solution(start, goal, iters, explored, path, depth);
+	free(path);
+	return 0;
+}
+
+/* Sets up one direction of bidirectional_search(), searching from 'root'
+ * toward 'target' */
+void init_side(SearchSide* side, uint64_t root, uint64_t target){
+	side->table = make_table(1 << 16);
+	side->open = make_queue(QUEUE_PRIORITIES);
+	side->h_table = malloc(TILES * sizeof(*side->h_table));
+	assert(side->h_table);
+	build_goal_table(target, side->h_table);
+	init_histogram(&side->f_hist);
+	init_histogram(&side->g_hist);
+
+	int h = table_manhattan(root, side->h_table);
+	PackedNode node = make_packed_node(root, 0, h, MOVE_ROOT, packed_blank(root));
+	table_insert(side->table, node);
+	queue_push(side->open, h, node);
+	histogram_add(&side->f_hist, h);
+	histogram_add(&side->g_hist, 0);
+}
+
+/* Free memory allocated for one direction of bidirectional_search() */
+void destroy_side(SearchSide* side){
+	destroy_table(side->table);
+	destroy_queue(side->open);
+	free(side->h_table);
+}
+
+/* Bidirectional heuristic search that meets in the middle (the MM algorithm).
+ * One search runs forward from the start board toward the goal and one runs
+ * backward from the goal toward the start, each with the Manhattan Distance
+ * to its own target and its own NodeTable.  Nodes are expanded in order of
+ * max(f, 2g), always from the direction with the lower minimum priority, so
+ * neither search goes past the middle of the path.  Every generated child is
+ * looked up in the other direction's table, and the cheapest meeting gives
+ * the best solution cost U so far.  The search stops once U is no more than
+ * the lower bound max(C, fmin forward, fmin backward, gmin forward + gmin
+ * backward + 1), which proves U is optimal.  Returns 0 if a solution was
+ * found and -1 otherwise */
+int bidirectional_search(Board* start, Board* goal){
+	long iters = 0;                          // number of nodes removed from the open lists
+	long explored = 0;                       // number of states expanded in both directions
+	uint64_t start_state = pack_board(start);
+	uint64_t goal_state = pack_board(goal);
+	int best = INT_MAX;                      // U, the cost of the best path found so far
+	uint64_t meet = 0;                       // state where the forward and backward paths of 'best' meet
+	SearchSide sides[2];                     // forward and backward directions
+
+	if(start_state == goal_state){ // check if given node is equal to goal
+		printf("---SOLUTION FOUND---\n");
+		printf("initial board was equal to the goal board\n");
 		return 0;
 	}
-	return -1; 
-}
 
+	init_side(&sides[0], start_state, goal_state);
+	init_side(&sides[1], goal_state, start_state);
+
+	while(sides[0].open->size != 0 && sides[1].open->size != 0){
+		int c_forward = queue_min(sides[0].open);
+		int c_backward = queue_min(sides[1].open);
+		int bound = c_forward < c_backward ? c_forward : c_backward;
+		if(sides[0].f_hist.min > bound) bound = sides[0].f_hist.min;
+		if(sides[1].f_hist.min > bound) bound = sides[1].f_hist.min;
+		if(sides[0].g_hist.min + sides[1].g_hist.min + 1 > bound) bound = sides[0].g_hist.min + sides[1].g_hist.min + 1;
+		if(best <= bound) break;             // no path cheaper than 'best' is left
+
+		int dir = c_forward <= c_backward ? 0 : 1;
+		SearchSide* side = &sides[dir];
+		SearchSide* other = &sides[!dir];
+		PackedNode current;
+		queue_pop(side->open, &current);
+		histogram_remove(&side->f_hist, current.g + current.h);
+		histogram_remove(&side->g_hist, current.g);
+		iters++;
+		PackedNode* entry = table_find(side->table, current.state);
+		if((entry->move & MOVE_CLOSED) || entry->g < current.g) continue; // stale copy
+		entry->move |= MOVE_CLOSED;
+		explored++;
+
+		int blank = node_blank(&current);
+		for(int move = 0; move < 4; move++){ // generate each child of the current board
+			if(!move_possible(blank, move)) continue;
+			int target = blank + move_delta[move];
+			int tile = packed_tile(current.state, target);
+			int h = current.h + side->h_table[tile][blank] - side->h_table[tile][target];
+			uint64_t state = packed_move(current.state, blank, move);
+			PackedNode child = make_packed_node(state, current.g + 1, h, move, target);
+
+			PackedNode* found = table_find(side->table, state);
+			if(found != NULL && found->g <= child.g) continue; // already reached at least as cheaply
+			if(found == NULL){
+				table_insert(side->table, child);
+			} else {
+				*found = child;              // cheaper path, reopen the state if it was closed
+			}
+			int priority = child.g + child.h > 2 * child.g ? child.g + child.h : 2 * child.g;
+			queue_push(side->open, priority, child);
+			histogram_add(&side->f_hist, child.g + child.h);
+			histogram_add(&side->g_hist, child.g);
 
-/* Calculates the number of misplaced tiles on the board and
- * returns the number.  Can be added to h_score with manhattan
- * distance for a faster but less optimal solution. (NOT USED) */
-int misplaced(Board *brd){
-	int expected = 1; // holds index of current expected value
-	int sum = 0;      // holds the solution
-	for(int i = 0; i < ROWS; i++){
-		for(int j = 0; j < COLS; j++){
-			if((i == 3 && j == 3)) break;
-			if(brd->board[i][j] != expected){
-				sum++;
-				expected++;
+			PackedNode* reached = table_find(other->table, state); // did the other direction reach this state
+			if(reached != NULL && child.g + reached->g < best){
+				best = child.g + reached->g;
+				meet = state;
 			}
 		}
 	}
-	return sum;
+
+	int result = -1;
+	if(best != INT_MAX){
+		uint64_t* forward;                   // meet, ..., board one move after start
+		uint64_t* backward;                  // meet, ..., board one move before goal
+		int forward_steps = trace_packed_path(sides[0].table, table_find(sides[0].table, meet), &forward);
+		int backward_steps = trace_packed_path(sides[1].table, table_find(sides[1].table, meet), &backward);
+		int steps = forward_steps + backward_steps;
+		uint64_t* path = malloc(steps * sizeof(uint64_t));
+		assert(path);
+		int index = 0;
+		if(backward_steps > 0){              // goal first, then back to 'meet'
+			path[index++] = goal_state;
+			for(int i = backward_steps - 1; i > 0; i--){
+				path[index++] = backward[i];
+			}
+		}
+		for(int i = 0; i < forward_steps; i++){
+			path[index++] = forward[i];
+		}
+		print_solution(start, goal, iters, explored, path, steps);
+		free(forward);
+		free(backward);
+		free(path);
+		result = 0;
+	} else {
+		printf("\n----------SOLUTION NOT FOUND----------\n");
+	}
+	destroy_side(&sides[0]);
+	destroy_side(&sides[1]);
+	return result;
 }
 
-/* Calculates the Manhattan Distance for the given board and returns
- * it in the form of an int.  The Manhattan Distance is the sum of
- * the distances that all the tiles are misplaced on the board.
- * (the 0 or empty tile is not counted)  */
-int manhattan_distance(Board* brd){
-	int sum = 0;
-	//#pragma omp parallel for
-	for(int i = 0; i < ROWS; i++){
-		for(int j = 0; j < COLS; j++){
-			int value = brd->board[i][j];
-			if(value != 0){
-				int goal_x = value / ROWS;
-				int goal_y = value % COLS;
-				int dx = i - goal_x;
-				int dy = j - goal_y;
-				sum += (abs(dx) + abs(dy));
+/* Returns the lowest f = g + h of any valid (not stale) node in the open
+ * queue or the INCONS list of ara_star_search(), or INT_MAX if there is none */
+int ara_min_f(NodeTable* table, BucketQueue* open_list, OpenList* incons){
+	int min = INT_MAX;
+	for(int p = 0; p < open_list->priorities; p++){
+		OpenList* bucket = open_list->buckets[p];
+		for(size_t i = 0; bucket != NULL && i < bucket->size; i++){
+			PackedNode* entry = table_find(table, bucket->nodes[i].state);
+			if(!(entry->move & MOVE_CLOSED) && entry->g == bucket->nodes[i].g && entry->g + entry->h < min){
+				min = entry->g + entry->h;
 			}
 		}
 	}
-	return sum;
+	for(size_t i = 0; i < incons->size; i++){
+		PackedNode* entry = table_find(table, incons->nodes[i].state);
+		if(entry->g == incons->nodes[i].g && entry->g + entry->h < min){
+			min = entry->g + entry->h;
+		}
+	}
+	return min;
 }
 
-/* Takes in a pointer to a board and returns an array of all possible
- * actions that can be applied to the board. Allocates an array of length
- * 4 that contains actions */
-Action* possible_actions(Board* brd){
-	int max_actions = 4; // there will be at most 4 possible moves
-	Action* poss_actions = malloc(max_actions * sizeof(Action));
-	assert(poss_actions);
-	int index = 0; // keeps track of number of assigned elements to array
-
-	for(int i = 0; i < max_actions; i++){ // initialize the array with NULL actions
-		poss_actions[i] = make_action(NULL, -1, -1, -1);
-	}
-	//#pragma omp parallel for
-	for(int i = 0; i < ROWS; i++){
-		for(int j = 0; j < COLS; j++){
-			// check if you can move right
-			if(j != 3){
-				if(brd->board[i][j] != 0 && brd->board[i][j+1] == 0){
-					Action act = make_action("RIGHT", i, j, brd->board[i][j]);
-					poss_actions[index] = act;
-					index++;
-				}
+/* Anytime Repairing A* (ARA*).  Runs weighted A* starting with the weight
+ * from --weight (3 if none is given) to find a first solution quickly, then
+ * lowers the weight by --ara-step and searches again, printing each better
+ * solution with a bound on how far it can be from optimal.  Effort is reused
+ * between searches: the NodeTable and open queue are kept, and states whose g
+ * improves after they were explored are kept in an INCONS list and returned
+ * to the open queue for the next search instead of being explored again in
+ * the current one.  Stops when a search with weight 1 finishes (the last
+ * solution is optimal) or when --deadline seconds have passed.  Returns 0
+ * if a solution was found and -1 otherwise */
+int ara_star_search(Board* start, Board* goal){
+	long iters = 0;                          // number of searches (weights) run
+	long explored = 0;                       // number of states expanded in all searches
+	uint64_t start_state = pack_board(start);
+	uint64_t goal_state = pack_board(goal);
+	double w = options.weight >= 1 ? options.weight : 3;
+	int weight = scale_weight(w);
+	int best = INT_MAX;                      // g of the goal, the cost of the best solution so far
+	int timed_out = 0;
+	double began = MPI_Wtime();
+	NodeTable* table = make_table(1 << 16);  // every state generated so far
+	BucketQueue* open_list = make_queue(key_priorities(weight)); // the weight only goes down, so keys stay in range
+	OpenList* incons = make_open_list(64);   // explored states whose g improved during the current search
+
+	PackedNode first = make_packed_node(start_state, 0, heuristic(start_state), MOVE_ROOT, packed_blank(start_state));
+	table_insert(table, first);
+	queue_push(open_list, node_key(&first, weight), first);
+	if(start_state == goal_state) best = 0;
+
+	while(1){
+		int previous = best;
+		iters++;
+		// expand nodes until none could lead to a solution better than 'best' at this weight
+		while(open_list->size != 0 && !timed_out){
+			if(best != INT_MAX && queue_min(open_list) >= best * WEIGHT_SCALE) break;
+			PackedNode current;
+			queue_pop(open_list, &current);
+			PackedNode* entry = table_find(table, current.state);
+			if((entry->move & MOVE_CLOSED) || entry->g < current.g) continue; // stale copy
+			entry->move |= MOVE_CLOSED;
+			explored++;
+			if(options.deadline > 0 && (explored & 1023) == 0 && MPI_Wtime() - began > options.deadline){
+				timed_out = 1;
 			}
-			// check if you can move left
-			if(j != 0){
-				if(brd->board[i][j] != 0 && brd->board[i][j-1] == 0){
-					Action act = make_action("LEFT", i, j, brd->board[i][j]);
-					poss_actions[index] = act;
-					index++;
+
+			int blank = node_blank(&current);
+			for(int move = 0; move < 4; move++){
+				if(!move_possible(blank, move)) continue;
+				uint64_t state = packed_move(current.state, blank, move);
+				int h = child_heuristic(current.state, current.h, blank, move, state);
+				PackedNode child = make_packed_node(state, current.g + 1, h, move, blank + move_delta[move]);
+
+				PackedNode* found = table_find(table, state);
+				if(found == NULL){
+					table_insert(table, child);
+					queue_push(open_list, node_key(&child, weight), child);
+				} else if(found->g > child.g){
+					int closed = found->move & MOVE_CLOSED;
+					*found = child;
+					if(closed){                  // explored already, wait for the next search
+						found->move |= MOVE_CLOSED;
+						open_push(incons, child);
+					} else {
+						queue_push(open_list, node_key(&child, weight), child);
+					}
+				} else {
+					continue;
 				}
-			}
-			// check if you can move up
-			if(i != 0){
-				if(brd->board[i][j] != 0 && brd->board[i-1][j] == 0){
-					Action act = make_action("UP", i, j, brd->board[i][j]);
-					poss_actions[index] = act;
-					index++;
+				if(state == goal_state && child.g < best){
+					best = child.g;
 				}
 			}
-			// check if you can move down
-			if(i != 3){
-				if(brd->board[i][j] != 0 && brd->board[i+1][j] == 0){
-					Action act = make_action("DOWN", i, j, brd->board[i][j]);
-					poss_actions[index] = act;
-					index++;
+		}
+
+		if(best < previous){                 // print the better solution and its bound
+			uint64_t* path;
+			int steps = trace_packed_path(table, table_find(table, goal_state), &path);
+			int min_f = ara_min_f(table, open_list, incons);
+			double bound = min_f == INT_MAX ? 1 : (double)best / min_f;
+			if(bound > w) bound = w;
+			print_solution(start, goal, iters, explored, path, steps);
+			printf("WEIGHT %.2f: SOLUTION IS AT MOST %.3f TIMES OPTIMAL (%f seconds)\n", w, bound < 1 ? 1 : bound, MPI_Wtime() - began);
+			free(path);
+		}
+		if(timed_out || weight <= WEIGHT_SCALE || (open_list->size == 0 && incons->size == 0)) break;
+
+		// lower the weight, move INCONS into the open queue, and reorder it for the new weight
+		w = w - options.ara_step > 1 ? w - options.ara_step : 1;
+		weight = scale_weight(w);
+		BucketQueue* reordered = make_queue(open_list->priorities);
+		PackedNode node;
+		while(queue_pop(open_list, &node) != -1){
+			queue_push(reordered, node_key(&node, weight), node);
+		}
+		for(size_t i = 0; i < incons->size; i++){
+			queue_push(reordered, node_key(&incons->nodes[i], weight), incons->nodes[i]);
+		}
+		incons->size = 0;
+		destroy_queue(open_list);
+		open_list = reordered;
+		for(size_t i = 0; i < table->capacity; i++){ // the closed set starts empty in each search
+			table->slots[i].move &= ~MOVE_CLOSED;
+		}
+	}
+
+	if(best == INT_MAX){
+		printf("\n----------SOLUTION NOT FOUND----------\n");
+	} else if(timed_out){
+		printf("DEADLINE REACHED AT WEIGHT %.2f\n", w);
+	} else {
+		printf("WEIGHT 1.00 SEARCH FINISHED: LAST SOLUTION IS OPTIMAL\n");
+	}
+	destroy_table(table);
+	destroy_queue(open_list);
+	destroy_open_list(incons);
+	return best == INT_MAX ? -1 : 0;
+}
+
+/* Reads the 16 values of a board, row by row, from a string like
+ * "15 11 13 12 14 10 8 9 7 2 5 1 3 6 4 0" into the given Board.
+ * Returns 0 on success and -1 if the string is not a valid board */
+int parse_board(char* str, Board* brd){
+	int seen[TILES] = { 0 };
+	char* pos = str;
+	for(int index = 0; index < TILES; index++){
+		char* end;
+		long value = strtol(pos, &end, 10);
+		if(end == pos || value < 0 || value >= TILES || seen[value]) return -1;
+		seen[value] = 1;
+		brd->board[index / COLS][index % COLS] = value;
+		pos = end;
+	}
+	return 0;
+}
+
+/* Opens the result cache file 'path' with room for about 'entries'
+ * entries of paths to 'goal_state' (collective).  Proc 0 maps it read-write
+ * and creates it, or starts it over if it does not hold a cache of the same
+ * size and goal; the other
+ * procs map it read-only if they can open it (it is only shared with the
+ * procs on proc 0's node when 'path' is on local disk).  Returns NULL on
+ * procs that could not map the file */
+ResultCache* cache_open(char* path, long entries, uint64_t goal_state){
+	int sets = 1;
+	while((long)sets * CACHE_WAYS < entries) sets *= 2;
+	size_t bytes = sizeof(CacheHeader) + (size_t)sets * CACHE_WAYS * sizeof(CacheEntry);
+	int fd = -1;
+	if(rank == 0){
+		fd = open(path, O_RDWR | O_CREAT, 0644);
+		if(fd >= 0){
+			CacheHeader header;
+			if(pread(fd, &header, sizeof(header), 0) != sizeof(header) || header.magic != CACHE_MAGIC || header.sets != (uint32_t)sets
+					|| header.goal_state != goal_state){
+				if(ftruncate(fd, 0) != 0 || ftruncate(fd, bytes) != 0){ // a new, zeroed cache
+					close(fd);
+					fd = -1;
 				}
 			}
 		}
 	}
-	return poss_actions;
+	MPI_Barrier(MPI_COMM_WORLD);             // the file exists before the other procs open it
+	if(rank != 0) fd = open(path, O_RDONLY);
+	void* base = MAP_FAILED;
+	if(fd >= 0){
+		base = mmap(NULL, bytes, rank == 0 ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+	}
+	if(base == MAP_FAILED){
+		if(rank == 0) perror(path);
+		return NULL;
+	}
+	ResultCache* cache = malloc(sizeof(ResultCache));
+	assert(cache);
+	cache->header = base;
+	cache->entries = (CacheEntry*)(cache->header + 1);
+	cache->bytes = bytes;
+	cache->sets = sets;
+	cache->writable = rank == 0;
+	if(cache->writable){
+		cache->header->magic = CACHE_MAGIC;
+		cache->header->sets = sets;
+		cache->header->goal_state = goal_state;
+	}
+	return cache;
+}
+
+/* Writes the cache back to its file and unmaps it */
+void cache_close(ResultCache* cache){
+	if(cache->writable) msync(cache->header, cache->bytes, MS_SYNC);
+	munmap(cache->header, cache->bytes);
+	free(cache);
 }
 
-/* Takes in an Action and a Board.  Returns a copy of
- * the given board after the given Action is applied to it. 
- * The Action results in the given tile being swapped with the
- * tile in the given direction. Allocates space for a single Board
- * (this is where the boards h_score is assigned) */
-Board* result(Action act, Board* brd) {
-	int move;                           // represents the tile to be moved  
-	Board* result = make_empty_board(); // allocate space for a new Board
+/* Returns the cache entry of a state, or NULL if it is not cached */
+CacheEntry* cache_find(ResultCache* cache, uint64_t state){
+	CacheEntry* set = &cache->entries[(hash_state(state) & (cache->sets - 1)) * CACHE_WAYS];
+	for(int way = 0; way < CACHE_WAYS; way++){
+		if(set[way].state == state) return &set[way];
+	}
+	return NULL;
+}
 
-	//#pragma omp parallel for
-	for(int i = 0; i < ROWS; i++){      // copy the 2d array into the new board
-		for(int j = 0; j < COLS; j++){
-			result->board[i][j] = brd->board[i][j];
+/* Stores the cost to the goal and the first move toward it of a state.
+ * An entry is only replaced by a better one (exact, or as exact and
+ * cheaper).  A new state takes an empty way of its set, or the least
+ * recently used one */
+void cache_store(ResultCache* cache, uint64_t state, int cost, int move, int exact){
+	CacheEntry* entry = cache_find(cache, state);
+	if(entry != NULL){
+		if(entry->exact > exact || (entry->exact == exact && entry->cost <= cost)) return;
+	} else {
+		CacheEntry* set = &cache->entries[(hash_state(state) & (cache->sets - 1)) * CACHE_WAYS];
+		entry = &set[0];
+		for(int way = 0; way < CACHE_WAYS && entry->state != 0; way++){
+			if(set[way].state == 0 || set[way].last_used < entry->last_used) entry = &set[way];
 		}
 	}
-	// set the parent board to the Board before action is applied
-	result->parent = brd;
+	entry->state = state;
+	entry->cost = cost;
+	entry->move = move;
+	entry->exact = exact;
+	entry->last_used = ++cache->header->clock;
+}
 
-	if(strcmp(act.direction, "RIGHT") == 0){
-		move = result->board[act.row][act.col];
-		result->board[act.row][act.col] = result->board[act.row][act.col + 1];
-		result->board[act.row][act.col + 1] = move;
-	} else if(strcmp(act.direction, "LEFT") == 0){
-		move = result->board[act.row][act.col];
-		result->board[act.row][act.col] = result->board[act.row][act.col - 1];
-		result->board[act.row][act.col - 1] = move;
-	} else if(strcmp(act.direction, "UP") == 0){
-		move = result->board[act.row][act.col];
-		result->board[act.row][act.col] = result->board[act.row - 1][act.col];
-		result->board[act.row - 1][act.col] = move;
-	} else { // "DOWN"
-		move = result->board[act.row][act.col];
-		result->board[act.row][act.col] = result->board[act.row + 1][act.col];
-		result->board[act.row + 1][act.col] = move;
+/* Stores every state of a solved request's path with its cost to the goal,
+ * so a later request from any of them is answered by cache_answer() */
+void cache_store_path(ResultCache* cache, uint64_t state, ServeResult* result, int exact){
+	for(int i = 0; i < result->steps; i++){
+		int move = result->moves[i];
+		cache_store(cache, state, result->steps - i, move, exact);
+		state = packed_move(state, packed_blank(state), move);
 	}
-	// set the h_score to the manhattan distance 
-	result->h_score = manhattan_distance(result);
+}
 
-	return result;
+/* Answers a request from the cache by following the stored first moves
+ * from its state to the goal.  With 'need_exact' only optimal entries are
+ * used.  Returns 1 and fills 'result' on a hit, or 0 if the state is not
+ * cached or the chain to the goal was broken by an eviction */
+int cache_answer(ResultCache* cache, uint64_t state, uint64_t goal_state, int need_exact, ServeResult* result){
+	CacheEntry* first = cache_find(cache, state);
+	if(first == NULL || (need_exact && !first->exact)) return 0;
+	int steps = 0;
+	while(state != goal_state){
+		CacheEntry* entry = cache_find(cache, state);
+		if(entry == NULL || (need_exact && !entry->exact) || steps == MAX_PATH) return 0;
+		result->moves[steps++] = entry->move;
+		state = packed_move(state, packed_blank(state), entry->move);
+	}
+	if(cache->writable) first->last_used = ++cache->header->clock;
+	result->steps = steps;
+	result->explored = 0;
+	return 1;
 }
 
-/* Takes in a board and returns an array of boards that are the
- * result of applying all possible actions to the given board. 
- * Allocates and frees space for an array of size 4 containing 
- * Board structs and allocates space for the LinkedList that 
- * is returned */
-LinkedList* expand(Board* brd){
-	int index = 0;                               // current index of acts array
-	Action* acts = possible_actions(brd);        // list of possible actions to perform on brd
-	LinkedList* list = make_list();              // linkedlist to hold the boards after actions are performed
+/* Returns the exact cost to the goal of a state if the cache has it, or
+ * -1.  Used as a perfect heuristic value by serve_solve() */
+int cache_cost(ResultCache* cache, uint64_t state){
+	if(cache == NULL) return -1;
+	CacheEntry* entry = cache_find(cache, state);
+	return entry != NULL && entry->exact ? entry->cost : -1;
+}
+
+/* Solves one request for serve() with a best-first search ordered by
+ * node_key(), like a_star_search() on a single proc.  The table and open
+ * list are emptied first but keep their memory, so they stay warm from one
+ * request to the next.  With a result cache, a state whose exact cost is
+ * cached gets it as its h, and the search stops at the first explored
+ * state that cache_answer() can finish (only exact entries with
+ * 'need_exact', so the solution stays optimal).  Gives up after
+ * options.serve_limit explored nodes */
+void serve_solve(NodeTable* table, BucketQueue* open_list, Histogram* f_hist, ResultCache* cache, int need_exact, uint64_t start_state, uint64_t goal_state, int weight, ServeResult* result){
+	double begin = MPI_Wtime();
+	clear_table(table);
+	clear_queue(open_list);
+	init_histogram(f_hist);
+	result->steps = -1;
+	result->explored = 0;
+	int h = cache_cost(cache, start_state);
+	PackedNode first = make_packed_node(start_state, 0, h >= 0 ? h : heuristic(start_state), MOVE_ROOT, packed_blank(start_state));
+	table_insert(table, first);
+	queue_push(open_list, node_key(&first, weight), first);
 
-	while(acts[index].direction != NULL){        // for each action, add resulting board to the end of list
-		Board* tmp = result(acts[index], brd);
-		Node* node = make_node(tmp);
-		push(list, node);
-		index++;
-		if(index == 4) break;
+	PackedNode current;
+	while(result->explored < options.serve_limit && queue_pop(open_list, &current) != -1){
+		PackedNode* entry = table_find(table, current.state);
+		if((entry->move & MOVE_CLOSED) || entry->g < current.g) continue; // stale copy
+		entry->move |= MOVE_CLOSED;
+		result->explored++;
+		ServeResult* tail = result;          // the moves from 'current' to the goal are stored after its g moves
+		int rest = 0;
+		if(current.state != goal_state && cache != NULL && cache_find(cache, current.state) != NULL){
+			tail = malloc(sizeof(ServeResult));
+			assert(tail);
+			if(cache_answer(cache, current.state, goal_state, need_exact, tail) && current.g + tail->steps <= MAX_PATH){
+				rest = tail->steps;
+				memcpy(result->moves + current.g, tail->moves, rest);
+			}
+			free(tail);
+		}
+		if(current.state == goal_state || rest > 0){ // store the moves, start first
+			result->steps = current.g + rest;
+			for(int i = current.g - 1; i >= 0; i--){
+				int move = entry->move & MOVE_MASK;
+				result->moves[i] = move;
+				entry = table_find(table, packed_move(entry->state, node_blank(entry), move ^ 1));
+			}
+			break;
+		}
+		if(current.g + 1 >= MAX_PATH) continue;
+		int blank = node_blank(&current);
+		for(int move = 0; move < 4; move++){
+			if(!move_possible(blank, move)) continue;
+			uint64_t state = packed_move(current.state, blank, move);
+			int h = cache_cost(cache, state);
+			if(h < 0){                       // the parent's h may be a cached cost, which child_heuristic() cannot update
+				h = cache != NULL ? heuristic(state) : child_heuristic(current.state, current.h, blank, move, state);
+			}
+			add_open_node(table, open_list, f_hist, make_packed_node(state, current.g + 1, h, move, blank + move_delta[move]), weight);
+		}
 	}
-	free(acts);
-	return list;
+	result->seconds = MPI_Wtime() - begin;
 }
 
-int find_parents(Board* brd){
-	int parents = 0;
-	Board * tmp = brd;
-	while(tmp->parent != NULL){
-		parents++;
-		tmp = tmp->parent;
-		//parents++;
+/* Writes a reply line to a client.  A client that has hung up (fd -1 or a
+ * closed socket) is ignored */
+void serve_reply(int fd, char* line){
+	if(fd >= 0) send(fd, line, strlen(line), MSG_NOSIGNAL);
+}
+
+/* Gives a lane of lockstep_ida() the next of its boards that needs a
+ * search, or leaves it idle (board -1) when none is left.  'next_board' is
+ * the position in 'boards' of the next board to hand out.  Returns 1 if the
+ * lane got a board */
+int lane_take(Lane* lane, uint64_t* states, ServeResult* results, int* boards, int count, int* next_board, uint64_t goal_state){
+	while(*next_board < count){
+		int board = boards[(*next_board)++];
+		uint64_t state = states[board];
+		results[board].steps = state == goal_state ? 0 : -1;
+		results[board].explored = 0;
+		results[board].seconds = 0;
+		if(state == goal_state) continue;
+		lane->board = board;
+		lane->depth = 0;
+		lane->states[0] = state;
+		lane->hs[0] = packed_manhattan(state);
+		lane->blanks[0] = packed_blank(state);
+		lane->next[0] = 0;
+		lane->fsm[0] = 0;
+		lane->bound = lane->hs[0];
+		lane->next_bound = INT_MAX;
+		return 1;
 	}
-	return parents;
+	lane->board = -1;
+	return 0;
 }
 
+/* Returns the next move of a lane's search from the end of its path,
+ * backing up from the states whose moves are all tried and starting the
+ * next iteration with a higher bound once the whole tree within the bound
+ * is searched.  Moves the FSM prunes are skipped.  Returns -1 if the
+ * search gives up: after options.serve_limit nodes, or when the bound
+ * would pass MAX_PATH */
+int lane_next_move(Lane* lane, ServeResult* result){
+	while(result->explored < options.serve_limit){
+		int d = lane->depth;
+		while(lane->next[d] < 4){
+			int move = lane->next[d]++;
+			if(move_possible(lane->blanks[d], move) && fsm_next[lane->fsm[d]][move] >= 0) return move;
+		}
+		if(d > 0){
+			lane->depth--;                   // every move from here is tried, back to the parent
+		} else if(lane->next_bound < MAX_PATH){
+			lane->bound = lane->next_bound;  // the tree is searched, start the next iteration
+			lane->next_bound = INT_MAX;
+			lane->next[0] = 0;
+		} else {
+			return -1;
+		}
+	}
+	return -1;
+}
 
-/* Informed search algorithm that finds a path or solution
- * from the start board to the goal board. The heuristic function 
- * used is the Manhattan Distance which is calculated and assigned 
- * in the result() function.  Return ) if a solution was found 
- * and -1 otherwise.  Algorithm is described further in the README file */
-int a_star_search(Board* start, Board* goal, int rank, int nprocs){
-	int solution_found = 0;                 // set to 0 meaning no solution has been found, updated to 1 when a solution is found
-	int iters = 1;                          // holds count of loop iterations which equals the number of explored states
-	int checker = 0;                        // used with MPI_Allreduce to check if any proc found the solution
-	LinkedList* closed_list = make_list();  // list to hold boards that have already been explored
-	LinkedList* open_list = make_list();    // list to hold boards that have yet to be explored
-	Node* first = make_node(start);         // first board to explore, the given 'start' board
-	first->board->h_score = manhattan_distance(first->board); // set initial h_score
-	push(open_list, first);                 // add initial board to open list
-
-	if(compare_boards(start->board, goal->board) == 0){ // check if given node is equal to goal
-		printf("---SOLUTION FOUND---\n");
-		printf("initial board was equal to the goal board\n");
+/* Moves a lane's search to 'child', made from the end of its path by
+ * 'move', whose Manhattan Distance is h and f is f, unless the lane kernel
+ * found f above the bound ('over'), then f is kept for the next iteration.
+ * Returns 1 if the child is the goal, then 'result' holds the moves */
+int lane_enter(Lane* lane, ServeResult* result, int move, uint64_t child, int h, int f, int over, uint64_t goal_state){
+	int d = lane->depth;
+	if(over){
+		if(f < lane->next_bound) lane->next_bound = f;
 		return 0;
 	}
-    
-	while(open_list->size != 0){ // while the open_list is not empty
-
-		// need to update first and stop values due to the changing size of the linked list each iteration
-		int first = (rank * open_list->size) / nprocs;                
-		int stop = (((rank+1) * open_list->size) / nprocs);
-
-		Node* remove = find_min_h(open_list); // initially, all procs check entire list until there are enough values for efficient parallelization
-		if(open_list->size < nprocs*2){ // check entire list
-			remove = find_min_h(open_list);
-		}else{
-			remove = find_min_h_parallel(open_list, first, stop); // only check portion of list the proc owns
-		}
-
-		Board* b = make_empty_board();         // will be the board in Node 'current'
-		copy_board(remove->board, b);       
-		Node* current = make_node(b);          // current is a copy of the removed board
-		push(closed_list, remove);             // add node to closed list
-		remove_node(open_list, remove);        // remove node from the open list
-		
-		if(compare_boards(current->board->board, goal->board) == 0){ // if solution was found, print solution sequence and return
-			printf("\n----------SOLUTION FOUND----------\n");
-			printf("\nITERATIONS: %d\n", iters);
-			print_parents(current);
-			printf("INITIAL BOARD:\n");
-			print_board(start);
-			printf("\nFINAL BOARD:\n");
-			print_board(goal);
-			printf("\n---------------------------\n");
-			printf("EXPLORED %d STATES\n", closed_list->size);
-			printf("---------------------------\n");
-			printf("\n----------SOLUTION FOUND-----------\n");
-			solution_found = 1;
-		}
-
-		MPI_Allreduce(&solution_found, &checker, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD); // checks if solution was found by any proc
-
-		if(checker > 0){ // exit the function bc solution was found
-			free_list(closed_list);
-			free_list(open_list);
-			return 0;
+	result->explored++;
+	result->moves[d] = move;
+	if(child == goal_state){
+		result->steps = d + 1;
+		return 1;
+	}
+	if(d + 1 >= MAX_PATH) return 0;
+	lane->depth = d + 1;
+	lane->states[d + 1] = child;
+	lane->hs[d + 1] = h;
+	lane->blanks[d + 1] = lane->blanks[d] + move_delta[move];
+	lane->next[d + 1] = 0;
+	lane->fsm[d + 1] = fsm_next[lane->fsm[d]][move];
+	return 0;
+}
+
+/* Solves the boards states[boards[k]] (all solvable) with IDA* and the
+ * Manhattan Distance, IDA_LANES of them at a time in lockstep, and stores
+ * each solution in results[boards[k]].  In every step each lane picks its
+ * next move (lane_next_move()), one call of the lane kernel makes and
+ * scores the children of all lanes together (AVX2 when the CPU has it, see
+ * lane_kernel()), and each lane goes down to its child or keeps its f for
+ * the next iteration (lane_enter()).  Every lane has its own bound, and a
+ * lane whose board is done takes the next one, so the lanes stay full
+ * until the last boards.  The solutions are optimal, and a board gives up
+ * after options.serve_limit nodes */
+void lockstep_ida(uint64_t* states, ServeResult* results, int* boards, int count, uint64_t goal_state){
+	LaneKernel kernel = lane_kernel();
+	Lane* lanes = malloc(IDA_LANES * sizeof(Lane));
+	assert(lanes);
+	double begin = MPI_Wtime();
+	int next_board = 0;
+	int busy = 0;                            // lanes with a board
+	for(int l = 0; l < IDA_LANES; l++){
+		busy += lane_take(&lanes[l], states, results, boards, count, &next_board, goal_state);
+	}
+	while(busy > 0){
+		uint64_t parents[IDA_LANES], children[IDA_LANES];
+		int blanks[IDA_LANES], targets[IDA_LANES], moves[IDA_LANES];
+		int hs[IDA_LANES], gs[IDA_LANES], bounds[IDA_LANES], child_hs[IDA_LANES], fs[IDA_LANES];
+		for(int l = 0; l < IDA_LANES; l++){  // pick each lane's move, a lane whose search ends takes a new board
+			Lane* lane = &lanes[l];
+			moves[l] = -1;
+			while(lane->board >= 0 && (moves[l] = lane_next_move(lane, &results[lane->board])) < 0){
+				results[lane->board].seconds = MPI_Wtime() - begin;
+				if(!lane_take(lane, states, results, boards, count, &next_board, goal_state)) busy--;
+			}
+			if(moves[l] < 0){                // idle, indexes on the board for the kernel
+				parents[l] = 0;
+				blanks[l] = targets[l] = 0;
+				hs[l] = gs[l] = bounds[l] = 0;
+			} else {
+				parents[l] = lane->states[lane->depth];
+				blanks[l] = lane->blanks[lane->depth];
+				targets[l] = blanks[l] + move_delta[moves[l]];
+				hs[l] = lane->hs[lane->depth];
+				gs[l] = lane->depth + 1;
+				bounds[l] = lane->bound;
+			}
+		}
+		int over = kernel(parents, blanks, targets, hs, gs, bounds, children, child_hs, fs);
+		for(int l = 0; l < IDA_LANES; l++){
+			Lane* lane = &lanes[l];
+			if(moves[l] < 0) continue;
+			if(lane_enter(lane, &results[lane->board], moves[l], children[l], child_hs[l], fs[l], (over >> l) & 1, goal_state)){
+				results[lane->board].seconds = MPI_Wtime() - begin;
+				if(!lane_take(lane, states, results, boards, count, &next_board, goal_state)) busy--;
+			}
+		}
+	}
+	free(lanes);
+}
+
+/* Solves a batch of requests (collective).  Proc 0 answers the requests
+ * it can from the result cache, then sends the other boards to every proc.
+ * Proc 0 hands out the boards on demand: each other proc asks for one
+ * (IDA_LANES with --lockstep) when it is done with the last ones, sending
+ * their results back with the request, so a hard board only holds up the
+ * proc solving it.  A proc solves its boards with its resident table and
+ * open list (proc 0 only does so when it is alone).  Proc 0 then replies to
+ * the clients: "solved STEPS MOVES" (the moves of the 0 tile as U, D, L, R)
+ * or "failed", followed by the explored nodes, the time the request waited
+ * for its batch and the time to solve it, and the proc that solved it
+ * ("cached" is added for answers from the cache).  With --lockstep each
+ * proc solves its boards together with lockstep_ida() instead, so every
+ * answer is optimal.  A request whose line
+ * was not a board (state 0) gets "error bad board", and one that cannot
+ * be solved (packed_solvable()) "error unsolvable board".  A board and its
+ * mirror are solved as the lower of the two (canonical_state()), so they
+ * share cache entries.  The new solutions are
+ * then stored in the cache, between batches, while no proc reads it */
+void serve_batch(ServeRequest* requests, int count, NodeTable* table, BucketQueue* open_list, Histogram* f_hist, ResultCache* cache, uint64_t goal_state, int weight, struct pollfd* fds, int rank, int nprocs){
+	uint64_t* states = malloc(count * sizeof(uint64_t)); // 0 for the requests proc 0 answers itself
+	ServeResult* results = malloc(count * sizeof(ServeResult));
+	int* cached = calloc(count, sizeof(int));
+	int* mirrored = calloc(count, sizeof(int)); // 1 if the mirrored board is solved, see canonical_state()
+	assert(states && results && cached && mirrored);
+	int exact = weight == WEIGHT_SCALE || options.lockstep; // plain A* or IDA* with an admissible heuristic finds optimal paths
+	double begin = MPI_Wtime();
+	if(rank == 0){
+		for(int i = 0; i < count; i++){
+			states[i] = requests[i].state;
+			results[i].worker = 0;
+			results[i].seconds = 0;
+			if(states[i] == 0){
+				results[i].steps = -2;
+			} else if(!packed_solvable(states[i])){ // no search needed to know there is no solution
+				results[i].steps = -3;
+				states[i] = 0;
+			} else {
+				mirrored[i] = canonical_state(states[i], &states[i]);
+				if(cache != NULL && cache_answer(cache, states[i], goal_state, exact, &results[i])){
+					results[i].seconds = MPI_Wtime() - begin;
+					cached[i] = 1;
+					states[i] = 0;
+				}
+			}
+		}
+	}
+	MPI_Bcast(states, count, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+	int chunk = options.lockstep ? IDA_LANES : 1; // boards handed out at once, enough to fill the lanes
+	int* work = malloc(count * sizeof(int)); // the boards this proc solves next
+	assert(work);
+	if(nprocs == 1){                         // no one to hand boards to, proc 0 solves them all
+		int size = 0;
+		for(int i = 0; i < count; i++){
+			if(states[i] != 0) work[size++] = i;
 		}
+		if(options.lockstep) lockstep_ida(states, results, work, size, goal_state);
+		for(int j = 0; j < size; j++){
+			int i = work[j];
+			if(!options.lockstep) serve_solve(table, open_list, f_hist, cache, exact, states[i], goal_state, weight, &results[i]);
+			results[i].worker = 0;
+		}
+	} else if(rank == 0){                    // hand the next boards to whichever proc asks first
+		ServeResult* done = malloc(chunk * sizeof(ServeResult));
+		assert(done);
+		int next = 0;
+		int active = nprocs - 1;             // procs not yet told the batch is done
+		while(active > 0){
+			MPI_Status status;
+			MPI_Probe(MPI_ANY_SOURCE, TAG_SERVE, MPI_COMM_WORLD, &status);
+			int bytes;
+			MPI_Get_count(&status, MPI_BYTE, &bytes);
+			MPI_Recv(done, bytes, MPI_BYTE, status.MPI_SOURCE, TAG_SERVE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			for(int j = 0; j < bytes / (int)sizeof(ServeResult); j++) results[done[j].request] = done[j];
+			int size = 0;
+			for(; next < count && size < chunk; next++){
+				if(states[next] != 0) work[size++] = next;
+			}
+			MPI_Send(work, size, MPI_INT, status.MPI_SOURCE, TAG_SERVE_WORK, MPI_COMM_WORLD);
+			if(size == 0) active--;
+		}
+		free(done);
+	} else {                                 // ask proc 0 for boards, sending the results of the last ones
+		ServeResult* done = malloc(chunk * sizeof(ServeResult));
+		assert(done);
+		int size = 0;
+		while(1){
+			MPI_Send(done, size * sizeof(ServeResult), MPI_BYTE, 0, TAG_SERVE, MPI_COMM_WORLD);
+			MPI_Status status;
+			MPI_Recv(work, chunk, MPI_INT, 0, TAG_SERVE_WORK, MPI_COMM_WORLD, &status);
+			MPI_Get_count(&status, MPI_INT, &size);
+			if(size == 0) break;
+			if(options.lockstep) lockstep_ida(states, results, work, size, goal_state);
+			for(int j = 0; j < size; j++){
+				int i = work[j];
+				if(!options.lockstep) serve_solve(table, open_list, f_hist, cache, exact, states[i], goal_state, weight, &results[i]);
+				results[i].worker = rank;
+				results[i].request = i;
+				done[j] = results[i];
+			}
+		}
+		free(done);
+	}
+	free(work);
+	if(rank == 0){
+		static const char letters[4] = { 'U', 'D', 'L', 'R' };
+		char* line = malloc(MAX_PATH + 256);
+		assert(line);
+		for(int i = 0; i < count; i++){
+			ServeResult* result = &results[i];
+			int length;
+			if(result->steps == -2 || result->steps == -3){
+				serve_reply(fds[requests[i].client].fd, result->steps == -2 ? "error bad board\n" : "error unsolvable board\n");
+				continue;
+			} else if(result->steps >= 0){
+				length = sprintf(line, "solved %d ", result->steps);
+				for(int j = 0; j < result->steps; j++){ // the moves of the mirrored board are mirrored back
+					int move = result->moves[j];
+					line[length++] = letters[mirrored[i] ? transpose_move[move] : move];
+				}
+			} else {
+				length = sprintf(line, "failed");
+			}
+			sprintf(line + length, " explored %ld wait %.3f ms solve %.3f ms proc %d%s\n", result->explored,
+				(begin - requests[i].arrival) * 1000, result->seconds * 1000, result->worker, cached[i] ? " cached" : "");
+			serve_reply(fds[requests[i].client].fd, line);
+		}
+		free(line);
+	}
+	MPI_Barrier(MPI_COMM_WORLD);             // every proc is done reading the cache
+	if(rank == 0 && cache != NULL){
+		for(int i = 0; i < count; i++){
+			if(states[i] != 0 && results[i].steps > 0) cache_store_path(cache, states[i], &results[i], exact);
+		}
+	}
+	free(states);
+	free(results);
+	free(cached);
+	free(mirrored);
+}
+
+/* Runs the solver as a service on the UNIX domain socket 'path' (all procs
+ * take part).  Proc 0 accepts clients and reads their requests, one board
+ * per line (16 values, as for --board), and every proc keeps its table, open
+ * list and heuristic tables between requests, so a request pays no startup
+ * cost.  Requests that arrive while a batch is being solved are gathered
+ * into the next batch (up to options.serve_batch), which is spread over
+ * the procs by serve_batch().  Replies go back in the order of each client's
+ * requests.  A line "quit" stops the service once the waiting requests are
+ * answered.  Returns 0, or -1 if the socket could not be opened */
+int serve(char* path, Board* goal, int rank, int nprocs){
+	int weight = scale_weight(options.weight);
+	uint64_t goal_state = pack_board(goal);
+	NodeTable* table = make_table(1 << 16);
+	BucketQueue* open_list = make_queue(key_priorities(weight));
+	Histogram* f_hist = malloc(sizeof(Histogram));
+	assert(f_hist);
+	ResultCache* cache = options.cache_file != NULL ? cache_open(options.cache_file, options.cache_entries, goal_state) : NULL;
+	struct pollfd fds[SERVE_MAX_CLIENTS + 1]; // fds[0] is the listening socket, then the clients
+	char (*buffers)[SERVE_LINE] = NULL;      // text read from each client, up to a full line
+	int* lengths = NULL;
+	ServeRequest* pending = NULL;            // requests waiting for a batch, in order of arrival
+	int count = 0;
+	int running = 1;
 
-		LinkedList* check_list = expand(current->board); // list of boards resulting from expand(), need to check if they have been explored or not
-		Node* check = check_list->head;
+	if(rank == 0){
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+		unlink(path);                        // left over from an earlier run
+		fds[0].fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		fds[0].events = POLLIN;
+		if(fds[0].fd < 0 || bind(fds[0].fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fds[0].fd, SERVE_MAX_CLIENTS) != 0){
+			perror(path);
+			running = 0;
+		} else {
+			printf("serving on %s with %d procs\n", path, nprocs);
+			fflush(stdout);
+		}
+		for(int c = 1; c <= SERVE_MAX_CLIENTS; c++){
+			fds[c].fd = -1;
+			fds[c].events = POLLIN;
+		}
+		buffers = malloc(SERVE_MAX_CLIENTS * SERVE_LINE);
+		lengths = calloc(SERVE_MAX_CLIENTS, sizeof(int));
+		pending = malloc(options.serve_batch * sizeof(ServeRequest));
+		assert(buffers && lengths && pending);
+	}
+	int ok = running;
+	MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-		while(check != NULL){
-			Node *copy;
-			Board* x = make_empty_board();
-			copy_board(check->board, x);
-			copy = make_node(x);
+	while(ok){
+		int batch = 0;                       // number of requests in the next batch, -1 to stop
+		if(rank == 0){
+			while(running && count == 0){    // wait until there is something to solve
+				for(int c = 1; c <= SERVE_MAX_CLIENTS && running; c++){ // take the complete lines read so far
+					char* buffer = buffers[c - 1];
+					char* line = buffer;
+					char* newline;
+					while(fds[c].fd >= 0 && (newline = strchr(line, '\n')) != NULL && count < options.serve_batch){
+						*newline = '\0';
+						Board board;
+						if(strncmp(line, "quit", 4) == 0){
+							running = 0;
+							break;
+						}
+						pending[count].client = c;
+						pending[count].state = parse_board(line, &board) == 0 ? pack_board(&board) : 0; // 0 is answered with an error, in order
+						pending[count].arrival = MPI_Wtime();
+						count++;
+						line = newline + 1;
+					}
+					lengths[c - 1] -= line - buffer; // keep the start of the next line
+					memmove(buffer, line, lengths[c - 1] + 1);
+				}
+				if(count > 0 || !running) break;
 
-			if(in_list(closed_list, copy) == 0){         // if the node is in the closed list, go to next iteration
-				check = check->next;
-				continue;
-			} else if (in_list(open_list, copy) == 0){   // if the node is in the open list, check if the existing node has a worse solution (parents) 
-				Node* tmp = open_list->head;
-				while(tmp != NULL){
-					if(compare_boards(tmp->board->board, copy->board->board) == 0){
-						break;
+				poll(fds, SERVE_MAX_CLIENTS + 1, -1);
+				if(fds[0].revents & POLLIN){
+					int fd = accept(fds[0].fd, NULL, NULL);
+					int c = 1;
+					while(c <= SERVE_MAX_CLIENTS && fds[c].fd >= 0) c++;
+					if(c > SERVE_MAX_CLIENTS){
+						if(fd >= 0) close(fd); // too many clients
+					} else {
+						fds[c].fd = fd;
+						lengths[c - 1] = 0;
+						buffers[c - 1][0] = '\0';
 					}
-					tmp = tmp->next;
 				}
-				if(find_parents(tmp->board) > find_parents(copy->board)){
-					tmp->board->parent = copy->board->parent;
-					tmp->board->h_score = copy->board->h_score;
-					check = check->next;
-					continue;
-				} else {
-					check = check->next;
-					continue;
+				for(int c = 1; c <= SERVE_MAX_CLIENTS; c++){
+					if(fds[c].fd < 0 || !(fds[c].revents & (POLLIN | POLLHUP))) continue;
+					if(lengths[c - 1] == SERVE_LINE - 1) lengths[c - 1] = 0; // line too long, drop it
+					ssize_t got = read(fds[c].fd, buffers[c - 1] + lengths[c - 1], SERVE_LINE - 1 - lengths[c - 1]);
+					if(got <= 0){            // the client hung up
+						close(fds[c].fd);
+						fds[c].fd = -1;
+					} else {
+						lengths[c - 1] += got;
+						buffers[c - 1][lengths[c - 1]] = '\0';
+					}
 				}
-			}    
-            push(open_list, copy); // node is not in either list, add it to open_list 
-			check = check->next;
-		} // while
-		iters++;
-	} // while
-	return -1; // no solution was found
+			}
+			batch = count > 0 ? count : -1;
+		}
+		MPI_Bcast(&batch, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		if(batch < 0) break;
+		serve_batch(pending, batch, table, open_list, f_hist, cache, goal_state, weight, fds, rank, nprocs);
+		count = 0;
+	}
+
+	if(rank == 0){
+		for(int c = 0; c <= SERVE_MAX_CLIENTS; c++){
+			if(fds[c].fd >= 0) close(fds[c].fd);
+		}
+		unlink(path);
+		free(buffers);
+		free(lengths);
+		free(pending);
+	}
+	destroy_table(table);
+	destroy_queue(open_list);
+	free(f_hist);
+	if(cache != NULL) cache_close(cache);
+	return ok ? 0 : -1;
+}
+
+/* Races a different search on every proc (race_strategies[rank %
+ * RACE_STRATEGIES]) on the same board.  The first proc to find a solution
+ * sends a cancel message to the others, which check for it every
+ * RACE_POLL nodes and stop, so the time to a solution is that of the
+ * fastest strategy for the board.  If procs finish at nearly the same time,
+ * the one that finished first by MPI_Wtime() wins.  Proc 0 prints the
+ * winner's solution and strategy.  Returns 0 if a solution was found and
+ * -1 otherwise */
+int portfolio_search(Board* start, Board* goal, int rank, int nprocs){
+	RaceStrategy* strategy = &race_strategies[rank % RACE_STRATEGIES];
+	uint64_t start_state = pack_board(start);
+	uint64_t goal_state = pack_board(goal);
+	ServeResult* result = malloc(sizeof(ServeResult));
+	assert(result);
+	result->steps = -1;
+	result->worker = rank;
+	result->explored = 0;
+	Race* race = make_race(nprocs);
+	double begin = MPI_Wtime();
+
+	int solved = strategy->ida ? race_ida(race, start_state, goal_state, 0, result, NULL) : race_best_first(strategy, race, start_state, goal_state, result);
+	result->seconds = MPI_Wtime() - begin;
+	if(solved && !race->cancelled) race_cancel(race, rank, nprocs);
+	race_finish(race, nprocs);
+
+	struct { double seconds; int rank; } mine, first; // the earliest solution over all procs
+	mine.seconds = solved ? result->seconds : DBL_MAX;
+	mine.rank = rank;
+	MPI_Allreduce(&mine, &first, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
+	long total_explored = 0;
+	MPI_Reduce(&result->explored, &total_explored, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	if(first.seconds != DBL_MAX){
+		if(first.rank != 0){
+			if(rank == first.rank) MPI_Send(result, sizeof(ServeResult), MPI_BYTE, 0, TAG_RACE, MPI_COMM_WORLD);
+			if(rank == 0) MPI_Recv(result, sizeof(ServeResult), MPI_BYTE, first.rank, TAG_RACE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		}
+		if(rank == 0){
+			print_move_solution(start, goal, result->explored, total_explored, result);
+			printf("SOLUTION FOUND BY PROC %d (%s) IN %.3f SECONDS\n", first.rank, race_strategies[first.rank % RACE_STRATEGIES].name, first.seconds);
+		}
+	} else if(rank == 0){
+		printf("\n----------SOLUTION NOT FOUND----------\n");
+	}
+	free(result);
+	return first.seconds != DBL_MAX ? 0 : -1;
+}
+
+/* Prints the command line options */
+void usage(char* program){
+	printf("usage: %s [options]\n", program);
+	printf("  --board \"B\"        start board, 16 values row by row (default: the 80 move TEST board)\n");
+	printf("  --goal \"B\"         goal board, 16 values row by row (default: 0 to 15 in order, the 0 tile top left)\n");
+	printf("  --disk DIR         external-memory A*, open and closed sets in files under DIR\n");
+	printf("  --disk-buffer N    nodes per I/O buffer and sorted run with --disk (default %zu)\n", options.disk_buffer);
+	printf("  --frontier         breadth-first heuristic frontier search without a closed list\n");
+	printf("  --bidirectional    bidirectional search (MM) meeting in the middle\n");
+	printf("  --weight W         order nodes by g + W*h (weighted A*, within W times optimal), default: by h only\n");
+	printf("  --optimal          keep searching until the solution is proven optimal across all procs\n");
+	printf("  --partial          partial expansion (EPEA*): only generate the children a node needs now\n");
+	printf("  --batch K          explore the K best boards per iteration, children generated together (default %d)\n", options.batch);
+	printf("  --lookahead K      explore the children whose priority is no higher than their parent's at once, up to K moves deep\n");
+	printf("  --sync N           iterations between checks for a solution across procs (default %d)\n", options.sync_interval);
+	printf("  --steal-low N      ask a random proc for work below N open boards, 0 to never steal (default %d)\n", options.steal_low);
+	printf("  --steal-batch N    most boards given away per request for work (default %d)\n", options.steal_batch);
+	printf("  --pdb              use an additive 6-6-3 pattern database heuristic (shared by the procs on a node)\n");
+	printf("  --checkpoint P     save the search to files P.<rank> every --checkpoint-every iterations\n");
+	printf("  --checkpoint-every N  iterations between checkpoints (default %ld)\n", options.checkpoint_every);
+	printf("  --restart          resume from the --checkpoint files, with any number of procs\n");
+	printf("  --numa             one copy of the shared --pdb tables per socket instead of per node (search tables are per proc)\n");
+	printf("  --pdb-file FILE    load the pattern database from FILE, or build it and save it there\n");
+	printf("  --ara              anytime ARA*: start at --weight (default 3) and lower it after each solution\n");
+	printf("  --ara-step S       amount --ara lowers the weight by (default %.1f)\n", options.ara_step);
+	printf("  --deadline SEC     stop --ara after SEC seconds with the best solution so far\n");
+	printf("  --rma-closed N     share explored states between procs, N per proc in an MPI one-sided window\n");
+	printf("  --memory MB        memory budget of each proc's search tables, shed open boards and then switch to IDA* when it is nearly used\n");
+	printf("  --ida              IDA* on proc 0 with a transposition table and move pruning\n");
+	printf("  --tt-size N        entries of the IDA* transposition table, 0 for none (default %ld)\n", options.tt_entries);
+	printf("  --no-fsm           do not prune duplicate move sequences in IDA*\n");
+	printf("  --portfolio        race a different search on every proc, the first to finish stops the others\n");
+	printf("  --serve PATH       run as a solver service on the UNIX domain socket PATH, one board per line\n");
+	printf("  --serve-batch N    most requests solved together by the procs (default %d)\n", options.serve_batch);
+	printf("  --cache FILE       keep --serve's solutions in a memory mapped cache file, reused across runs\n");
+	printf("  --cache-size N     states the cache has room for (default %ld)\n", options.cache_entries);
+	printf("  --serve-limit N    most nodes explored for one request before it fails (default %ld)\n", options.serve_limit);
+	printf("  --lockstep         solve --serve requests with IDA*, %d boards per proc in lockstep SIMD lanes\n", IDA_LANES);
+}
+
+/* Sets the global options from the command line, and the start and goal
+ * boards if they are given.  Returns 0 on success and -1 on a bad argument */
+int parse_args(int argc, char* argv[], Board* start, Board* goal){
+	for(int i = 1; i < argc; i++){
+		int has_value = i + 1 < argc;
+		if(strcmp(argv[i], "--board") == 0 && has_value){
+			if(parse_board(argv[++i], start) != 0) return -1;
+		} else if(strcmp(argv[i], "--goal") == 0 && has_value){
+			if(parse_board(argv[++i], goal) != 0) return -1;
+		} else if(strcmp(argv[i], "--disk") == 0 && has_value){
+			options.mode = MODE_DISK;
+			options.disk_dir = argv[++i];
+		} else if(strcmp(argv[i], "--bidirectional") == 0){
+			options.mode = MODE_BIDIRECTIONAL;
+		} else if(strcmp(argv[i], "--weight") == 0 && has_value){
+			options.weight = atof(argv[++i]);
+			if(options.weight < 1) return -1;
+		} else if(strcmp(argv[i], "--partial") == 0){
+			options.partial = 1;
+		} else if(strcmp(argv[i], "--batch") == 0 && has_value){
+			options.batch = atoi(argv[++i]);
+			if(options.batch < 1) return -1;
+		} else if(strcmp(argv[i], "--optimal") == 0){
+			options.optimal = 1;
+		} else if(strcmp(argv[i], "--sync") == 0 && has_value){
+			options.sync_interval = atoi(argv[++i]);
+			if(options.sync_interval < 1) return -1;
+		} else if(strcmp(argv[i], "--steal-low") == 0 && has_value){
+			options.steal_low = atoi(argv[++i]);
+			if(options.steal_low < 0) return -1;
+		} else if(strcmp(argv[i], "--steal-batch") == 0 && has_value){
+			options.steal_batch = atoi(argv[++i]);
+			if(options.steal_batch < 1) return -1;
+		} else if(strcmp(argv[i], "--pdb") == 0){
+			options.use_pdb = 1;
+		} else if(strcmp(argv[i], "--numa") == 0){
+			options.numa = 1;
+		} else if(strcmp(argv[i], "--checkpoint") == 0 && has_value){
+			options.checkpoint = argv[++i];
+		} else if(strcmp(argv[i], "--checkpoint-every") == 0 && has_value){
+			options.checkpoint_every = atol(argv[++i]);
+			if(options.checkpoint_every < 1) return -1;
+		} else if(strcmp(argv[i], "--restart") == 0){
+			options.restart = 1;
+		} else if(strcmp(argv[i], "--pdb-file") == 0 && has_value){
+			options.use_pdb = 1;
+			options.pdb_file = argv[++i];
+		} else if(strcmp(argv[i], "--ida") == 0){
+			options.mode = MODE_IDA;
+		} else if(strcmp(argv[i], "--tt-size") == 0 && has_value){
+			options.tt_entries = atol(argv[++i]);
+			if(options.tt_entries < 0) return -1;
+		} else if(strcmp(argv[i], "--rma-closed") == 0 && has_value){
+			options.closed_entries = atol(argv[++i]);
+			if(options.closed_entries < 0) return -1;
+		} else if(strcmp(argv[i], "--lookahead") == 0 && has_value){
+			options.lookahead = atoi(argv[++i]);
+			if(options.lookahead < 0 || options.lookahead > MAX_PATH) return -1;
+		} else if(strcmp(argv[i], "--memory") == 0 && has_value){
+			char* end;
+			long megabytes = strtol(argv[++i], &end, 10);
+			if(end == argv[i] || *end != '\0' || megabytes <= 0 || (unsigned long)megabytes > SIZE_MAX >> 20) return -1;
+			memory_budget = (size_t)megabytes << 20;
+		} else if(strcmp(argv[i], "--no-fsm") == 0){
+			options.fsm = 0;
+		} else if(strcmp(argv[i], "--portfolio") == 0){
+			options.mode = MODE_PORTFOLIO;
+		} else if(strcmp(argv[i], "--ara") == 0){
+			options.mode = MODE_ARA;
+		} else if(strcmp(argv[i], "--ara-step") == 0 && has_value){
+			options.ara_step = atof(argv[++i]);
+			if(options.ara_step <= 0) return -1;
+		} else if(strcmp(argv[i], "--deadline") == 0 && has_value){
+			options.deadline = atof(argv[++i]);
+		} else if(strcmp(argv[i], "--serve") == 0 && has_value){
+			options.mode = MODE_SERVE;
+			options.serve_path = argv[++i];
+		} else if(strcmp(argv[i], "--serve-batch") == 0 && has_value){
+			options.serve_batch = atoi(argv[++i]);
+			if(options.serve_batch < 1) return -1;
+		} else if(strcmp(argv[i], "--cache") == 0 && has_value){
+			options.cache_file = argv[++i];
+		} else if(strcmp(argv[i], "--cache-size") == 0 && has_value){
+			options.cache_entries = atol(argv[++i]);
+			if(options.cache_entries < 1) return -1;
+		} else if(strcmp(argv[i], "--serve-limit") == 0 && has_value){
+			options.serve_limit = atol(argv[++i]);
+			if(options.serve_limit < 1) return -1;
+		} else if(strcmp(argv[i], "--lockstep") == 0){
+			options.lockstep = 1;
+		} else if(strcmp(argv[i], "--frontier") == 0){
+			options.mode = MODE_FRONTIER;
+		} else if(strcmp(argv[i], "--disk-buffer") == 0 && has_value){
+			options.disk_buffer = strtoul(argv[++i], NULL, 10);
+			if(options.disk_buffer == 0) return -1;
+		} else {
+			return -1;
+		}
+	}
+	if(options.restart && options.checkpoint == NULL) return -1; // nothing to restart from
+	if(options.partial && options.batch > 1) return -1;         // --batch always generates every child
+	if(options.lookahead > 0 && (options.partial || options.batch > 1)) return -1; // probes are only made by single expansions of every child
+	return 0;
 }
 
 /* Starts the timer once all procs have reached the barrier.
@@ -632,7 +4033,8 @@ int main(int argc, char* argv[]){
 
 	/* GOAL is the goal board for all of the given test board,
 	 * the numbers go in order from top left to bottom right with 
-	 * the first space(index[0][0]) being empty(represented by a 0) */
+	 * the first space(index[0][0]) being empty(represented by a 0).
+	 * --goal replaces it */
 	Board* GOAL = make_empty_board();
 	GOAL->board[0][0] = 0;
 	GOAL->board[0][1] = 1;
@@ -675,16 +4077,53 @@ int main(int argc, char* argv[]){
 
 	MPI_Init(&argc, &argv);
 	setup();
+#ifdef _OPENMP
+	if(rank == 0 && omp_get_max_threads() > 1 && omp_get_proc_bind() == omp_proc_bind_false){
+		printf("warning: OpenMP threads are not pinned, set OMP_PROC_BIND=close and OMP_PLACES=cores\n");
+	}
+#endif
+
+	if(parse_args(argc, argv, TEST, GOAL) != 0){
+		if(rank == 0) usage(argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+	init_packed_tables(pack_board(GOAL));    // every heuristic and solvability check is for this goal
+	init_operator_table();
+	init_move_fsm();                         // needs options.fsm
+
+	int solvable = options.mode == MODE_SERVE || packed_solvable(pack_board(TEST)); // --serve checks each request
+	if(options.use_pdb && solvable){
+		pdb = make_pattern_db();
+	}
 
-	a_star_search(TEST, GOAL, rank, nprocs); // run parallel search, find path from TEST to GOAL
+	if(!solvable){                           // no search can reach the goal
+		if(rank == 0){
+			printf("\n----------SOLUTION NOT FOUND----------\n");
+			printf("the board is not solvable: the parity of its permutation differs from the parity\n");
+			printf("of the 0 tile's distance to its goal square, and every move flips both\n");
+		}
+	} else if(options.mode == MODE_DISK){
+		if(rank == 0) disk_a_star_search(TEST, GOAL); // the disk search runs on a single proc
+	} else if(options.mode == MODE_FRONTIER){
+		if(rank == 0) frontier_search(TEST, GOAL);    // so does the frontier search
+	} else if(options.mode == MODE_BIDIRECTIONAL){
+		if(rank == 0) bidirectional_search(TEST, GOAL);
+	} else if(options.mode == MODE_ARA){
+		if(rank == 0) ara_star_search(TEST, GOAL);
+	} else if(options.mode == MODE_SERVE){
+		serve(options.serve_path, GOAL, rank, nprocs); // every proc solves requests
+	} else if(options.mode == MODE_IDA){
+		if(rank == 0) ida_star_search(TEST, GOAL);
+	} else if(options.mode == MODE_PORTFOLIO){
+		portfolio_search(TEST, GOAL, rank, nprocs);
+	} else {
+		a_star_search(TEST, GOAL, rank, nprocs); // run parallel search, find path from TEST to GOAL
+	}
 
 	teardown();
+	if(pdb != NULL) destroy_pattern_db(pdb);
 	MPI_Finalize();
 
 	destroy_board(GOAL);
 }
-
-
-
-
-